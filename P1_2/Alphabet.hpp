@@ -0,0 +1,108 @@
+#ifndef _ALPHABET_HPP_
+#define _ALPHABET_HPP_
+
+#include <type_traits>
+
+/*
+* Alphabets a Hill cipher can work in.  A descriptor only says how many symbols there are (SIZE, which is also the modulus)
+* and which character each numerical value stands for (symbol); AlphabetTables works out everything else at compile time.
+*/
+
+//our 29 character alphabet: A-Z = 0-25, '.' = 26, '?' = 27, ' ' = 28
+struct Alpha29 {
+	static const unsigned int SIZE = 29;
+	static constexpr char symbol(unsigned int v) {
+		return v < 26 ? static_cast<char>('A' + v) : v == 26 ? '.' : v == 27 ? '?' : ' ';
+	}
+};
+
+//the classic alphabet: A-Z = 0-25
+struct Alpha26 {
+	static const unsigned int SIZE = 26;
+	static constexpr char symbol(unsigned int v) {
+		return static_cast<char>('A' + v);
+	}
+};
+
+//printable ASCII: ' ' (0x20) = 0 up to '~' (0x7E) = 94
+struct Printable95 {
+	static const unsigned int SIZE = 95;
+	static constexpr char symbol(unsigned int v) {
+		return static_cast<char>(' ' + v);
+	}
+};
+
+//raw bytes: every byte stands for itself
+struct Bytes256 {
+	static const unsigned int SIZE = 256;
+	static constexpr char symbol(unsigned int v) {
+		return static_cast<char>(static_cast<unsigned char>(v));
+	}
+};
+
+//0, 1, ..., N - 1 as a parameter pack, to fill tables element by element at compile time
+template<unsigned int... I> struct Indices {};
+template<unsigned int N, unsigned int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template<unsigned int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+/*
+* Returns the numerical value of byte c in alphabet A, looking from value v on, or bad if c isn't in A
+*/
+template<class A, class Code>
+constexpr Code codeOf(unsigned int c, unsigned int v, Code bad) {
+	return v == A::SIZE ? bad : static_cast<unsigned char>(A::symbol(v)) == c ? static_cast<Code>(v) : codeOf<A>(c, v + 1, bad);
+}
+
+/*
+* Extended Euclid on (r0, r1) with Bezout coefficients (t0, t1); returns the inverse of the starting r1 mod m, 0 if there is none
+*/
+constexpr unsigned int inverseOf(int r0, int r1, int t0, int t1, int m) {
+	return r1 == 0 ? (r0 == 1 ? static_cast<unsigned int>((t0 % m + m) % m) : 0) : inverseOf(r1, r0 % r1, t1, t0 - (r0 / r1) * t1, m);
+}
+
+/*
+* Lookup tables for alphabet A, generated at compile time:
+* CODE maps every byte to its numerical value (BAD if it isn't in A), SYMBOL maps every value back to its character,
+* INVERSE holds the multiplicative inverse of every value mod A::SIZE (0 where there is none)
+*/
+template<class A, class C = typename MakeIndices<256>::type, class V = typename MakeIndices<A::SIZE>::type>
+struct AlphabetTables;
+
+template<class A, unsigned int... C, unsigned int... V>
+struct AlphabetTables<A, Indices<C...>, Indices<V...> > {
+	//wide enough for every value and one more to mark bytes that aren't in A
+	typedef typename std::conditional<(A::SIZE < 256), unsigned char, unsigned short>::type Code;
+	static constexpr Code BAD = static_cast<Code>(-1);
+
+	static constexpr Code CODE[256] = { codeOf<A>(C, 0, BAD)... };
+	static constexpr char SYMBOL[A::SIZE] = { A::symbol(V)... };
+	static constexpr unsigned char INVERSE[A::SIZE] = { static_cast<unsigned char>(inverseOf(A::SIZE, V, 0, 1, A::SIZE))... };
+};
+
+template<class A, unsigned int... C, unsigned int... V>
+constexpr typename AlphabetTables<A, Indices<C...>, Indices<V...> >::Code AlphabetTables<A, Indices<C...>, Indices<V...> >::BAD;
+template<class A, unsigned int... C, unsigned int... V>
+constexpr typename AlphabetTables<A, Indices<C...>, Indices<V...> >::Code AlphabetTables<A, Indices<C...>, Indices<V...> >::CODE[256];
+template<class A, unsigned int... C, unsigned int... V>
+constexpr char AlphabetTables<A, Indices<C...>, Indices<V...> >::SYMBOL[A::SIZE];
+template<class A, unsigned int... C, unsigned int... V>
+constexpr unsigned char AlphabetTables<A, Indices<C...>, Indices<V...> >::INVERSE[A::SIZE];
+
+/*
+* Shorthands for our 29 character alphabet, shared by everything that turns text into numbers or back
+* (const, so every source file that includes this gets its own copy); in their own namespace so the short names don't clash
+*/
+namespace alpha29 {
+	//marks bytes that aren't in our 29 character alphabet
+	const unsigned char BAD = AlphabetTables<Alpha29>::BAD;
+
+	//numerical value of every byte: A-Z = 0-25, '.' = 26, '?' = 27, ' ' = 28, BAD for anything else
+	const unsigned char* const L2N = AlphabetTables<Alpha29>::CODE;
+
+	//character for every numerical value 0-28
+	const char* const N2L = AlphabetTables<Alpha29>::SYMBOL;
+
+	//multiplicative inverse of every value mod 29; e.g., INV29[2] = 15 (INV29[0] = 0 has no meaning)
+	const unsigned char* const INV29 = AlphabetTables<Alpha29>::INVERSE;
+}
+#endif
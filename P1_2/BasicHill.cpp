@@ -0,0 +1,345 @@
+#include "BasicHill.hpp"
+
+#include <algorithm>
+
+namespace {
+	/*
+	* Inverts the n-by-n matrix A (row by row, reduced mod p) over Z_p, p prime, by Gauss-Jordan elimination into X
+	* returns false if A is singular mod p
+	*/
+	bool invertPrime(const std::vector<unsigned int>& A, unsigned int n, unsigned int p, std::vector<unsigned int>& X) {
+		// [A | I] in one flat buffer, row by row
+		std::size_t w = 2 * n;
+		std::vector<unsigned int> M(n * w, 0);
+		for (unsigned int i = 0; i < n; i++) {
+			for (unsigned int j = 0; j < n; j++) {
+				M[i * w + j] = A[i * n + j] % p;
+			}
+			M[i * w + n + i] = 1;
+		}
+
+		for (unsigned int j = 0; j < n; j++) {
+			unsigned int r = j;
+			while (r < n && M[r * w + j] == 0) {
+				r++;
+			}
+			// nothing left to pivot on means the matrix is singular
+			if (r == n) {
+				return false;
+			}
+			if (r != j) {
+				std::swap_ranges(M.begin() + r * w, M.begin() + (r + 1) * w, M.begin() + j * w);
+			}
+
+			unsigned int* pivot = &M[j * w];
+			unsigned int inverse = inverseOf(p, pivot[j], 0, 1, p);
+			for (std::size_t c = j; c < w; c++) {
+				pivot[c] = pivot[c] * inverse % p;
+			}
+			for (unsigned int k = 0; k < n; k++) {
+				unsigned int f = M[k * w + j];
+				if (k == j || f == 0) {
+					continue;
+				}
+				unsigned int* row = &M[k * w];
+				for (std::size_t c = j; c < w; c++) {
+					row[c] = (row[c] + (p - f) * pivot[c]) % p;
+				}
+			}
+		}
+
+		X.resize(n * n);
+		for (unsigned int i = 0; i < n; i++) {
+			std::copy(M.begin() + i * w + n, M.begin() + (i + 1) * w, X.begin() + i * n);
+		}
+		return true;
+	}
+
+	/*
+	* Returns A * B mod q for n-by-n matrices stored row by row
+	*/
+	std::vector<unsigned int> multiply(const std::vector<unsigned int>& A, const std::vector<unsigned int>& B, unsigned int n, unsigned int q) {
+		std::vector<unsigned int> C(n * n, 0);
+		for (unsigned int i = 0; i < n; i++) {
+			unsigned int* c = &C[i * n];
+			// row i of C is a sum of rows of B, which keeps the inner loop contiguous
+			for (unsigned int k = 0; k < n; k++) {
+				unsigned int a = A[i * n + k];
+				const unsigned int* b = &B[k * n];
+				for (unsigned int j = 0; j < n; j++) {
+					c[j] += a * b[j];
+				}
+			}
+			for (unsigned int j = 0; j < n; j++) {
+				c[j] %= q;
+			}
+		}
+		return C;
+	}
+
+	/*
+	* Inverts the n-by-n matrix A (row by row, reduced mod m) over Z_m for any m up to 256
+	* A is inverted mod each prime p dividing m, the inverse is lifted to mod p^e (the full power of p in m) by Newton's iteration
+	* X <- X (2I - A X), which doubles the number of correct p-adic digits each time, and the pieces are put together by the Chinese remainder theorem
+	* returns an empty vector if A isn't invertible mod m
+	*/
+	std::vector<unsigned int> invert(const std::vector<unsigned int>& A, unsigned int n, unsigned int m) {
+		std::vector<unsigned int> result(n * n, 0);
+		unsigned int rest = m;
+		for (unsigned int p = 2; rest > 1; p++) {
+			if (rest % p != 0) {
+				continue;
+			}
+			unsigned int q = 1;
+			unsigned int e = 0;
+			while (rest % p == 0) {
+				rest /= p;
+				q *= p;
+				e++;
+			}
+
+			std::vector<unsigned int> X;
+			if (!invertPrime(A, n, p, X)) {
+				return std::vector<unsigned int>();
+			}
+			std::vector<unsigned int> Aq(A);
+			for (std::size_t i = 0; i < Aq.size(); i++) {
+				Aq[i] %= q;
+			}
+			for (unsigned int digits = 1; digits < e; digits *= 2) {
+				std::vector<unsigned int> T = multiply(Aq, X, n, q);
+				for (unsigned int i = 0; i < n; i++) {
+					for (unsigned int j = 0; j < n; j++) {
+						T[i * n + j] = ((i == j ? 2 : 0) + q - T[i * n + j]) % q;
+					}
+				}
+				X = multiply(X, T, n, q);
+			}
+
+			// c is 1 mod q and 0 mod every other prime power of m, so X * c is the piece of the inverse that belongs to q
+			unsigned int c = m / q * inverseOf(q, m / q % q, 0, 1, q) % m;
+			for (std::size_t i = 0; i < result.size(); i++) {
+				result[i] = (result[i] + X[i] * c) % m;
+			}
+		}
+		return result;
+	}
+}
+
+/**
+ * Default constructor.  No key is set, so E/D are 0-by-0 matrices until setE or setD succeeds.
+ */
+template<class Alphabet>
+BasicHill<Alphabet>::BasicHill() {
+	Matrix null(std::vector<int>(), 0, 0);
+	setKeys(null, null);
+}
+
+/**
+ * Parameterized constructor.  Use the parameter to set the encryption (E) and decryption (D) keys; if parameter is invalid then set E/D to a 0-by-0 matrix.
+ * @param K - a matrix representing the encryption or decryption key.
+ * @param encryption - true if the key is the encryption key, false if the key is the decryption key
+ */
+template<class Alphabet>
+BasicHill<Alphabet>::BasicHill(const Matrix& K, bool encryption) {
+	if (encryption) {
+		setE(K);
+	}
+	else {
+		setD(K);
+	}
+}
+
+/**
+ * Returns the current encryption key.
+ * @return the encryption key (Matrix E), reduced mod SIZE; if no encryption key is set a 0-by-0 matrix.
+ */
+template<class Alphabet>
+Matrix BasicHill<Alphabet>::getE() const {
+	return E;
+}
+
+/**
+ * Returns the current decryption key.
+ * @return the decryption key (Matrix D), reduced mod SIZE; if no decryption key is set a 0-by-0 matrix.
+ */
+template<class Alphabet>
+Matrix BasicHill<Alphabet>::getD() const {
+	return D;
+}
+
+/**
+ * Sets the encryption key (Matrix E) and decryption key (Matrix D); if the parameter is invalid then set E/D to a 0-by-0 matrix.
+ * @param E - encryption key.
+ * @return true if set is successful, false otherwise.
+ */
+template<class Alphabet>
+bool BasicHill<Alphabet>::setE(const Matrix& E) {
+	Matrix null(std::vector<int>(), 0, 0);
+	Matrix K = reduce(E);
+	unsigned int n = K.size(1);
+
+	// invert row by row; the inverse comes back row by row too, and Matrix wants it column-wise
+	std::vector<unsigned int> rows(n * n);
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			rows[i * n + j] = static_cast<unsigned int>(K.get(i, j));
+		}
+	}
+	std::vector<unsigned int> inverse = n == 0 ? std::vector<unsigned int>() : invert(rows, n, SIZE);
+	if (inverse.empty()) {
+		setKeys(null, null);
+		return false;
+	}
+	std::vector<int> columns(n * n);
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			columns[j * n + i] = static_cast<int>(inverse[i * n + j]);
+		}
+	}
+	setKeys(K, Matrix(columns, n, n));
+	return true;
+}
+
+/**
+ * Sets the decryption key (Matrix D) and encryption key (Matrix E); if the parameter is invalid then set E/D to a 0-by-0 matrix.
+ * @param D - decryption key.
+ * @return true if set is successful, false otherwise.
+ */
+template<class Alphabet>
+bool BasicHill<Alphabet>::setD(const Matrix& D) {
+	// the inverse of the inverse is the key itself, so set D as the encryption key and swap them around
+	if (!setE(D)) {
+		return false;
+	}
+	Matrix K = this->E;
+	setKeys(this->D, K);
+	return true;
+}
+
+/**
+ * Encrypt the given plaintext using the previous set encryption key, an empty string if the encryption key is invalid.
+ * @param P - the plaintext to encrypt
+ * @return the ciphertext, an empty string if P doesn't fill whole blocks or has a character outside the alphabet.
+ */
+template<class Alphabet>
+std::string BasicHill<Alphabet>::encrypt(const std::string& P) const {
+	std::string C(P.length(), '\0');
+	if (P.empty() || translate(EK, E.size(1), P.data(), P.length(), &C[0], C.length()) == 0) {
+		return "";
+	}
+	return C;
+}
+
+/**
+ * Decrypt the given ciphertext using the previous set decryption key, an empty string if the decryption key is invalid.
+ * @param C - the ciphertext to decrypt
+ * @return the plaintext, an empty string if C doesn't fill whole blocks or has a character outside the alphabet.
+ */
+template<class Alphabet>
+std::string BasicHill<Alphabet>::decrypt(const std::string& C) const {
+	std::string P(C.length(), '\0');
+	if (C.empty() || translate(DK, D.size(1), C.data(), C.length(), &P[0], P.length()) == 0) {
+		return "";
+	}
+	return P;
+}
+
+/**
+ * Encrypt the given plaintext using the previous set encryption key into a buffer supplied by the caller; never allocates memory.
+ * @param P - the plaintext to encrypt
+ * @param length - number of characters in P
+ * @param out - where the ciphertext goes (may be P itself)
+ * @param capacity - number of characters out has room for
+ * @return the number of characters written to out, 0 if the encryption key is invalid, P can't be encrypted or out is too small.
+ */
+template<class Alphabet>
+std::size_t BasicHill<Alphabet>::encrypt(const char* P, std::size_t length, char* out, std::size_t capacity) const {
+	return translate(EK, E.size(1), P, length, out, capacity);
+}
+
+/**
+ * Decrypt the given ciphertext using the previous set decryption key into a buffer supplied by the caller; never allocates memory.
+ * @param C - the ciphertext to decrypt
+ * @param length - number of characters in C
+ * @param out - where the plaintext goes (may be C itself)
+ * @param capacity - number of characters out has room for
+ * @return the number of characters written to out, 0 if the decryption key is invalid, C can't be decrypted or out is too small.
+ */
+template<class Alphabet>
+std::size_t BasicHill<Alphabet>::decrypt(const char* C, std::size_t length, char* out, std::size_t capacity) const {
+	return translate(DK, D.size(1), C, length, out, capacity);
+}
+
+/*
+* Sets E and D (which must be consistent, or both 0-by-0) and lays them out row by row
+*/
+template<class Alphabet>
+void BasicHill<Alphabet>::setKeys(const Matrix& E, const Matrix& D) {
+	this->E = E;
+	this->D = D;
+	unsigned int n = E.size(1);
+	EK.assign(n * n, 0);
+	DK.assign(n * n, 0);
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			// read the members: E or D may be the other member itself, which has just been overwritten
+			EK[i * n + j] = static_cast<unsigned int>(this->E.get(i, j));
+			DK[i * n + j] = static_cast<unsigned int>(this->D.get(i, j));
+		}
+	}
+}
+
+/*
+* Returns K reduced mod SIZE, a 0-by-0 matrix if K isn't square, smaller than 2-by-2 or bigger than MAX_KEY-by-MAX_KEY
+*/
+template<class Alphabet>
+Matrix BasicHill<Alphabet>::reduce(const Matrix& K) {
+	unsigned int n = K.size(1);
+	if (n < 2 || n > MAX_KEY || n != K.size(2)) {
+		return Matrix(std::vector<int>(), 0, 0);
+	}
+	return K.map([](int x) {
+		int value = x % static_cast<int>(SIZE);
+		return value < 0 ? value + static_cast<int>(SIZE) : value;
+	});
+}
+
+/*
+* Translates length characters of in with the n-by-n key K (row by row) into out, which has room for capacity characters
+* returns the number of characters written, 0 if there is no key, in isn't whole blocks or has a bad character, or out is too small
+*/
+template<class Alphabet>
+std::size_t BasicHill<Alphabet>::translate(const std::vector<unsigned int>& K, unsigned int n, const char* in, std::size_t length, char* out, std::size_t capacity) {
+	typedef AlphabetTables<Alphabet> Tables;
+	if (n == 0 || length % n != 0 || capacity < length) {
+		return 0;
+	}
+
+	// each element is below SIZE <= 256, so a whole dot product (at most MAX_KEY * 255 * 255) fits in 32 bits and is reduced once;
+	// SIZE is known at compile time, so the reduction is a multiply and shift (and just the low byte for 256 symbols)
+	unsigned int block[MAX_KEY];
+	for (std::size_t b = 0; b < length; b += n) {
+		for (unsigned int j = 0; j < n; j++) {
+			typename Tables::Code value = Tables::CODE[static_cast<unsigned char>(in[b + j])];
+			if (value == Tables::BAD) {
+				return 0;
+			}
+			block[j] = value;
+		}
+		for (unsigned int i = 0; i < n; i++) {
+			const unsigned int* row = &K[i * n];
+			unsigned int acc = 0;
+			for (unsigned int j = 0; j < n; j++) {
+				acc += row[j] * block[j];
+			}
+			out[b + i] = Tables::SYMBOL[acc % SIZE];
+		}
+	}
+	return length;
+}
+
+template class BasicHill<Alpha26>;
+template class BasicHill<Alpha29>;
+template class BasicHill<Printable95>;
+template class BasicHill<Bytes256>;
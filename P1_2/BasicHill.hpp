@@ -0,0 +1,123 @@
+#ifndef _BASICHILL_HPP_
+#define _BASICHILL_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Alphabet.hpp"
+#include "Matrix.hpp"
+
+/**
+ * A C++ class to perform encryption/decryption using the Hill cipher over any alphabet descriptor from Alphabet.hpp (26 letters, 95 printable
+ * ASCII characters, 256 bytes, ...); the alphabet size is the modulus, and it doesn't have to be prime.
+ * Hill itself stays the 29 character version, with the cryptanalysis; this one is instantiated in BasicHill.cpp for the descriptors in Alphabet.hpp.
+ */
+template<class Alphabet>
+class BasicHill
+{
+public:
+	//number of symbols in the alphabet, and so the modulus
+	static const unsigned int SIZE = Alphabet::SIZE;
+	//largest key (MAX_KEY-by-MAX_KEY) that is accepted, so a block always fits on the stack
+	static const unsigned int MAX_KEY = 256;
+
+	/**
+	 * Default constructor.  No key is set, so E/D are 0-by-0 matrices until setE or setD succeeds.
+	 */
+	BasicHill();
+
+	/**
+	 * Parameterized constructor.  Use the parameter to set the encryption (E) and decryption (D) keys; if parameter is invalid then set E/D to a 0-by-0 matrix.
+	 * @param K - a matrix representing the encryption or decryption key.
+	 * @param encryption - true if the key is the encryption key, false if the key is the decryption key
+	 */
+	BasicHill(const Matrix& K, bool encryption);
+
+	/**
+	 * Returns the current encryption key.
+	 * @return the encryption key (Matrix E), reduced mod SIZE; if no encryption key is set a 0-by-0 matrix.
+	 */
+	Matrix getE() const;
+
+	/**
+	 * Returns the current decryption key.
+	 * @return the decryption key (Matrix D), reduced mod SIZE; if no decryption key is set a 0-by-0 matrix.
+	 */
+	Matrix getD() const;
+
+	/**
+	 * Sets the encryption key (Matrix E) and decryption key (Matrix D); if the parameter is invalid then set E/D to a 0-by-0 matrix.
+	 * @param E - encryption key.
+	 * @return true if set is successful, false otherwise.
+	 */
+	bool setE(const Matrix& E);
+
+	/**
+	 * Sets the decryption key (Matrix D) and encryption key (Matrix E); if the parameter is invalid then set E/D to a 0-by-0 matrix.
+	 * @param D - decryption key.
+	 * @return true if set is successful, false otherwise.
+	 */
+	bool setD(const Matrix& D);
+
+	/**
+	 * Encrypt the given plaintext using the previous set encryption key, an empty string if the encryption key is invalid.
+	 * @param P - the plaintext to encrypt
+	 * @return the ciphertext, an empty string if P doesn't fill whole blocks or has a character outside the alphabet.
+	 */
+	std::string encrypt(const std::string& P) const;
+
+	/**
+	 * Decrypt the given ciphertext using the previous set decryption key, an empty string if the decryption key is invalid.
+	 * @param C - the ciphertext to decrypt
+	 * @return the plaintext, an empty string if C doesn't fill whole blocks or has a character outside the alphabet.
+	 */
+	std::string decrypt(const std::string& C) const;
+
+	/**
+	 * Encrypt the given plaintext using the previous set encryption key into a buffer supplied by the caller; never allocates memory.
+	 * @param P - the plaintext to encrypt
+	 * @param length - number of characters in P
+	 * @param out - where the ciphertext goes (may be P itself)
+	 * @param capacity - number of characters out has room for
+	 * @return the number of characters written to out, 0 if the encryption key is invalid, P can't be encrypted or out is too small.
+	 */
+	std::size_t encrypt(const char* P, std::size_t length, char* out, std::size_t capacity) const;
+
+	/**
+	 * Decrypt the given ciphertext using the previous set decryption key into a buffer supplied by the caller; never allocates memory.
+	 * @param C - the ciphertext to decrypt
+	 * @param length - number of characters in C
+	 * @param out - where the plaintext goes (may be C itself)
+	 * @param capacity - number of characters out has room for
+	 * @return the number of characters written to out, 0 if the decryption key is invalid, C can't be decrypted or out is too small.
+	 */
+	std::size_t decrypt(const char* C, std::size_t length, char* out, std::size_t capacity) const;
+
+private:
+	Matrix D; //current decryption key; must be consistent with E
+	Matrix E; //current encryption key; must be consistent with D
+	std::vector<unsigned int> DK; //D row by row, for translate()
+	std::vector<unsigned int> EK; //E row by row, for translate()
+
+	/*
+	* Sets E and D (which must be consistent, or both 0-by-0) and lays them out row by row
+	*/
+	void setKeys(const Matrix& E, const Matrix& D);
+
+	/*
+	* Returns K reduced mod SIZE, a 0-by-0 matrix if K isn't square, smaller than 2-by-2 or bigger than MAX_KEY-by-MAX_KEY
+	*/
+	static Matrix reduce(const Matrix& K);
+
+	/*
+	* Translates length characters of in with the n-by-n key K (row by row) into out, which has room for capacity characters
+	* returns the number of characters written, 0 if there is no key, in isn't whole blocks or has a bad character, or out is too small
+	*/
+	static std::size_t translate(const std::vector<unsigned int>& K, unsigned int n, const char* in, std::size_t length, char* out, std::size_t capacity);
+};
+
+typedef BasicHill<Alpha26> Hill26;
+typedef BasicHill<Printable95> Hill95;
+typedef BasicHill<Bytes256> Hill256;
+#endif
@@ -3,12 +3,247 @@
 // Author: Aadi Kothari
 
 #include "Hill.hpp"
+#include "Alphabet.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using alpha29::BAD;
+using alpha29::INV29;
+using alpha29::L2N;
+using alpha29::N2L;
+
+namespace {
+	/*
+	* Log-probabilities (times 100) of each symbol and each pair of consecutive symbols in ordinary English; the higher a text
+	* scores, the more it looks like English.  Counted over about 825,000 symbols of real text (Newton's Opticks and the usual
+	* free software licences), with every other character mapped to a space and 0.5 added to every count
+	*/
+	struct English {
+		int single[29];
+		int pair[29 * 29];
+	};
+
+	const English ENGLISH = {
+		{ -284, -421, -358, -352, -227, -376, -422, -312, -278, -760, -561, -346, -398, -291, -274, -403, -657, -288, -296, -251, -385, -495, -437, -605, -420, -864, -507, -901, -171 },
+		{
+			-1211, -666, -575, -652, -1191, -788, -694, -1175, -651, -1034, -721, -525, -636, -432, -1237, -661, -994, -498, -539, -476, -765, -728, -834, -908, -618, -1191, -1070, -1431, -565,
+			-806, -936, -966, -1046, -554, -1270, -1321, -1070, -743, -810, -1431, -605, -1127, -1211, -663, -1211, -1321, -694, -754, -966, -651, -1270, -1431, -1148, -602, -1431, -1051, -1431, -845,
+			-634, -1051, -759, -1065, -524, -1127, -1211, -571, -644, -1175, -720, -680, -1431, -1160, -494, -1175, -1102, -757, -1051, -560, -665, -1431, -1431, -1321, -1065, -1431, -908, -1431, -742,
+			-754, -1211, -1211, -784, -535, -1137, -876, -1127, -540, -1076, -1175, -847, -1148, -1191, -667, -1270, -1321, -852, -765, -907, -781, -1042, -1109, -1431, -849, -1431, -809, -1127, -414,
+			-569, -883, -568, -496, -607, -596, -740, -966, -640, -1160, -908, -633, -654, -474, -863, -725, -740, -426, -479, -604, -1076, -708, -788, -639, -686, -1191, -697, -1060, -325,
+			-713, -1321, -1270, -1431, -687, -736, -1051, -1321, -614, -1431, -1237, -714, -1127, -1321, -577, -1431, -1321, -581, -1118, -712, -808, -1431, -1431, -1431, -844, -1431, -997, -1431, -458,
+			-755, -1431, -1431, -1175, -612, -1191, -932, -599, -710, -1431, -1270, -689, -989, -780, -801, -994, -1237, -631, -794, -894, -801, -1431, -1431, -1321, -1127, -1431, -850, -1431, -557,
+			-527, -1191, -1431, -1211, -375, -1211, -1321, -1431, -533, -1191, -1321, -1127, -1042, -1118, -611, -1270, -1270, -753, -976, -619, -847, -1431, -1237, -1431, -898, -1321, -944, -1321, -521,
+			-700, -624, -525, -636, -630, -610, -594, -1321, -910, -1431, -832, -614, -644, -425, -512, -808, -844, -592, -493, -490, -829, -671, -1431, -786, -1431, -921, -911, -1431, -702,
+			-1034, -1431, -1431, -1431, -803, -1431, -1431, -1431, -1431, -1431, -1237, -1431, -1431, -1431, -1011, -1237, -1431, -1431, -1431, -1270, -966, -1431, -1431, -1431, -1431, -1431, -1211, -1431, -1065,
+			-980, -1431, -1321, -1431, -696, -1321, -1431, -1211, -800, -1431, -1321, -1051, -1237, -781, -1118, -1321, -1211, -1431, -842, -1270, -1137, -1431, -1237, -1431, -1211, -1431, -927, -1431, -650,
+			-584, -1321, -1076, -719, -513, -839, -1070, -1431, -515, -1270, -1137, -556, -985, -1127, -596, -997, -1431, -1046, -740, -792, -668, -863, -1014, -1431, -614, -1431, -926, -1321, -538,
+			-574, -765, -1027, -1321, -542, -1017, -1237, -1270, -636, -1431, -1270, -1020, -819, -957, -618, -693, -1321, -1137, -711, -1148, -732, -1118, -1431, -1270, -927, -1431, -881, -1160, -565,
+			-679, -1431, -583, -467, -551, -800, -518, -1321, -687, -1160, -902, -804, -1055, -805, -588, -1055, -1127, -1148, -532, -517, -740, -780, -1051, -1321, -666, -1431, -773, -1137, -435,
+			-850, -695, -736, -641, -863, -467, -727, -999, -787, -1237, -842, -592, -573, -451, -751, -615, -1431, -474, -621, -563, -506, -678, -633, -1076, -980, -1082, -1042, -1270, -498,
+			-582, -1431, -1321, -1118, -578, -1431, -1191, -808, -735, -1431, -1431, -647, -1191, -1175, -608, -685, -1137, -577, -910, -745, -711, -1431, -1109, -1431, -732, -1431, -931, -1431, -777,
+			-1431, -1431, -1237, -1431, -1321, -1270, -1431, -1431, -1431, -1431, -1237, -1431, -1321, -1321, -1431, -1431, -1431, -1042, -1431, -1270, -670, -1431, -1431, -1431, -1431, -1431, -1321, -1431, -899,
+			-514, -907, -692, -689, -433, -782, -777, -1046, -535, -1137, -690, -849, -657, -803, -544, -781, -1270, -751, -589, -602, -775, -760, -870, -1431, -655, -1431, -784, -1118, -436,
+			-689, -1321, -748, -1148, -488, -955, -1137, -666, -572, -1431, -966, -829, -711, -1160, -590, -664, -941, -1237, -593, -530, -614, -1148, -982, -1431, -885, -1431, -682, -1038, -384,
+			-603, -1175, -1023, -1175, -492, -1160, -1431, -348, -484, -1431, -1431, -720, -952, -997, -519, -997, -1137, -603, -608, -704, -716, -1191, -679, -1148, -694, -1270, -769, -1237, -408,
+			-708, -703, -671, -787, -708, -910, -745, -1431, -750, -1431, -1270, -664, -654, -624, -903, -714, -1431, -566, -608, -581, -1027, -1237, -1431, -1211, -1321, -1321, -958, -1431, -655,
+			-705, -1431, -1431, -1431, -536, -1431, -1431, -1431, -670, -1431, -1431, -1431, -1431, -1237, -901, -1431, -1431, -1431, -1237, -1191, -1102, -1431, -1321, -1191, -1160, -1431, -1027, -1431, -970,
+			-621, -1431, -1431, -1014, -662, -1431, -1431, -571, -597, -1431, -1431, -980, -1431, -838, -652, -1431, -1431, -921, -895, -1237, -1431, -1431, -1030, -1431, -1431, -1431, -922, -1321, -670,
+			-944, -1431, -824, -1431, -857, -1431, -1431, -935, -789, -1431, -1431, -1237, -1175, -1431, -1321, -769, -1431, -1211, -1431, -763, -1321, -1127, -1431, -1211, -978, -1431, -1065, -1431, -812,
+			-1034, -1160, -1321, -1321, -730, -1321, -1270, -1321, -839, -1431, -1237, -1070, -1070, -1137, -640, -987, -1431, -817, -680, -1109, -1431, -1431, -1431, -1270, -1211, -1065, -825, -1148, -454,
+			-1046, -1431, -1431, -1321, -992, -1431, -1431, -1431, -1065, -1431, -1431, -1321, -1431, -1431, -1088, -1321, -1431, -1431, -1431, -1431, -1270, -1431, -1431, -1431, -1321, -1431, -1175, -1431, -1002,
+			-1270, -1431, -1431, -1431, -1431, -1211, -1137, -1270, -1431, -1431, -1431, -1431, -1321, -1270, -1065, -1321, -1431, -1211, -1270, -1237, -1321, -1431, -1431, -1431, -1431, -1431, -1175, -1431, -508,
+			-1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -1431, -901,
+			-385, -473, -473, -517, -559, -500, -588, -606, -434, -923, -796, -515, -506, -574, -410, -482, -789, -504, -457, -339, -613, -620, -474, -914, -619, -1094, -683, -1270, -1431
+		}
+	};
+
+	/*
+	* The English model
+	*/
+	const English& english() {
+		return ENGLISH;
+	}
+
+	//a candidate key with its score
+	struct Scored {
+		long score;
+		unsigned int key;
+	};
+
+	/*
+	* Orders candidates best first (highest score, then lowest key number so results don't depend on thread timing)
+	*/
+	bool better(const Scored& a, const Scored& b) {
+		return a.score > b.score || (a.score == b.score && a.key < b.key);
+	}
+
+	/*
+	* Offers a candidate to a heap of the k best seen so far (the worst of them on top)
+	*/
+	void offer(std::vector<Scored>& heap, std::size_t k, const Scored& candidate) {
+		if (heap.size() < k) {
+			heap.push_back(candidate);
+			std::push_heap(heap.begin(), heap.end(), better);
+		}
+		else if (better(candidate, heap.front())) {
+			std::pop_heap(heap.begin(), heap.end(), better);
+			heap.back() = candidate;
+			std::push_heap(heap.begin(), heap.end(), better);
+		}
+	}
+
+	/*
+	* Process-wide cache of key inverses, least recently used first out once it holds capacity keys
+	* entries are found by a hash of the key and then compared element by element, so a collision only costs a miss
+	*/
+	struct InverseCache {
+		struct Entry {
+			std::uint64_t hash;
+			Matrix key;
+			Matrix inverse;
+		};
+
+		std::mutex lock;
+		std::size_t capacity = 1024;
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::list<Entry> entries; //most recently used first
+		std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+
+		/*
+		* Drops the least recently used entries until there are at most capacity of them
+		*/
+		void trim() {
+			while (entries.size() > capacity) {
+				index.erase(entries.back().hash);
+				entries.pop_back();
+			}
+		}
+	};
+
+	/*
+	* The cache, created the first time it is needed
+	*/
+	InverseCache& inverseCache() {
+		static InverseCache cache;
+		return cache;
+	}
+
+	/*
+	* FNV-1a hash of the size and elements of K
+	*/
+	std::uint64_t hashKey(const Matrix& K) {
+		std::uint64_t h = 14695981039346656037ULL;
+		std::uint64_t words[2] = { K.size(1), K.size(2) };
+		for (unsigned int i = 0; i < 2; i++) {
+			h = (h ^ words[i]) * 1099511628211ULL;
+		}
+		const int* a = K.data();
+		for (unsigned int i = 0; i < K.size(1) * K.size(2); i++) {
+			h = (h ^ static_cast<std::uint32_t>(a[i])) * 1099511628211ULL;
+		}
+		return h;
+	}
+
+#if defined(__SSE2__)
+	/*
+	* Converts 16 characters to their numerical values and widens them into out[0..15].
+	* Returns false (out is then unspecified) if any of the characters is outside the alphabet.
+	*/
+	bool l2num16(const char* in, int* out) {
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+		// letters are the bytes where c - 'A' is at most 25 when read as unsigned
+		__m128i letter = _mm_sub_epi8(c, _mm_set1_epi8('A'));
+		__m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(25)), letter);
+		__m128i isPeriod = _mm_cmpeq_epi8(c, _mm_set1_epi8('.'));
+		__m128i isQuestion = _mm_cmpeq_epi8(c, _mm_set1_epi8('?'));
+		__m128i isSpace = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+
+		__m128i valid = _mm_or_si128(_mm_or_si128(isLetter, isPeriod), _mm_or_si128(isQuestion, isSpace));
+		if (_mm_movemask_epi8(valid) != 0xFFFF) {
+			return false;
+		}
+
+		// each byte matches exactly one class, so the classes can simply be or'ed together
+		__m128i v = _mm_and_si128(isLetter, letter);
+		v = _mm_or_si128(v, _mm_and_si128(isPeriod, _mm_set1_epi8(26)));
+		v = _mm_or_si128(v, _mm_and_si128(isQuestion, _mm_set1_epi8(27)));
+		v = _mm_or_si128(v, _mm_and_si128(isSpace, _mm_set1_epi8(28)));
+
+		// widen bytes -> 16 bit -> 32 bit
+		__m128i zero = _mm_setzero_si128();
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(hi, zero));
+		return true;
+	}
+
+	/*
+	* Converts 16 numerical values (bytes, all in 0-28) to their characters.
+	*/
+	__m128i letters16(__m128i v) {
+		__m128i isPeriod = _mm_cmpeq_epi8(v, _mm_set1_epi8(26));
+		__m128i isQuestion = _mm_cmpeq_epi8(v, _mm_set1_epi8(27));
+		__m128i isSpace = _mm_cmpeq_epi8(v, _mm_set1_epi8(28));
+		__m128i isSymbol = _mm_or_si128(_mm_or_si128(isPeriod, isQuestion), isSpace);
+
+		__m128i r = _mm_andnot_si128(isSymbol, _mm_add_epi8(v, _mm_set1_epi8('A')));
+		r = _mm_or_si128(r, _mm_and_si128(isPeriod, _mm_set1_epi8('.')));
+		r = _mm_or_si128(r, _mm_and_si128(isQuestion, _mm_set1_epi8('?')));
+		r = _mm_or_si128(r, _mm_and_si128(isSpace, _mm_set1_epi8(' ')));
+		return r;
+	}
+
+	/*
+	* Converts 16 numerical values to characters in out[0..15].
+	* Returns false (nothing is written) if any value is outside 0-28.
+	*/
+	bool n2let16(const int* in, char* out) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4));
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12));
+
+		// anything negative or above 28 is left to the caller
+		__m128i top = _mm_set1_epi32(28);
+		__m128i zero = _mm_setzero_si128();
+		__m128i outside = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(a, top), _mm_cmpgt_epi32(b, top)),
+			_mm_or_si128(_mm_cmpgt_epi32(c, top), _mm_cmpgt_epi32(d, top)));
+		outside = _mm_or_si128(outside, _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(a, zero), _mm_cmplt_epi32(b, zero)),
+			_mm_or_si128(_mm_cmplt_epi32(c, zero), _mm_cmplt_epi32(d, zero))));
+		if (_mm_movemask_epi8(outside) != 0) {
+			return false;
+		}
+
+		// narrow 32 bit -> 16 bit -> bytes (no saturation happens since everything is in 0-28)
+		__m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), letters16(v));
+		return true;
+	}
+#endif
+}
+
 /**
    * Default constructor. It should set the encryption key to {2,4,3,5} (2-by-2) and the decryption key to its inverse.
    */
 Hill::Hill() {
-	E = Matrix({ 2,4,3,5 }, 2, 2);
-	D = inv_mod(E);
+	Matrix K({ 2,4,3,5 }, 2, 2);
+	setKeys(K, inverse(K));
 }
 
 /**
@@ -17,13 +252,14 @@ Hill::Hill() {
    * @param encryption - true if the key is the encryption key, false if the key is the decryption key
    */
 Hill::Hill(const Matrix& K, bool encryption) {
-	// checks if inverse of matrix is 0. Which means invalid parameters...
+	// checks if the key can be inverted at all (cheaply, through its determinant) before inverting it;
+	// a key that was set up before skips both and comes straight out of the cache
 	Matrix null(std::vector<int>(), 0, 0);
+	Matrix I = inverse(K);
 
-	if ((inv_mod(K).equal(null))) {
+	if (I.size(1) == 0) {
 		// if it is, then set both E and D to 0.
-		this->E = Matrix(std::vector<int>(), 0, 0);
-		this->D = Matrix(std::vector<int>(), 0, 0);
+		setKeys(null, null);
 		return;
 	}
 
@@ -31,14 +267,12 @@ Hill::Hill(const Matrix& K, bool encryption) {
 	else {
 		// if key is decryption key
 		if (!encryption) {
-			this->D = K;
-			this->E = this->inv_mod(this->D);
+			setKeys(I, K);
 		}
 
 		// otherwise if key is encryption key
 		else {
-			this->E = K;
-			this->D = this->inv_mod(this->E);
+			setKeys(K, I);
 		}
 	}
 }
@@ -51,14 +285,18 @@ Hill::Hill(const Matrix& K, bool encryption) {
 Hill::Hill(const Matrix& E, const Matrix& D) {
 	Matrix null(std::vector<int>(), 0, 0);
 
-	if ((E.size(2) > 1) && (E.size(1) > 1) && (D.size(1) > 1) && (D.size(2) > 1) && (E.size(1) == E.size(2)) && (D.size(1) == D.size(2)) && (D.equal(inv_mod(E))) && (E.equal(inv_mod(D))) && (inv_mod(E).equal(D)) && (inv_mod(D).equal(E)))
+	// E has to be reduced like inv_mod(D) would be; then D == inv_mod(E) also means E == inv_mod(D), so one inversion is enough
+	bool reduced = true;
+	for (unsigned int i = 0; i < E.size(1) * E.size(2); i++) {
+		reduced = reduced && E.data()[i] >= 0 && E.data()[i] < 29;
+	}
+
+	if ((E.size(2) > 1) && (E.size(1) > 1) && (D.size(1) > 1) && (D.size(2) > 1) && (E.size(1) == E.size(2)) && (D.size(1) == D.size(2)) && reduced && (D.equal(inverse(E))))
 	{
-		this->E = E;
-		this->D = D;
+		setKeys(E, D);
 	}
 	else {
-		this->E = null;
-		this->D = null;
+		setKeys(null, null);
 	}
 }
 
@@ -85,21 +323,15 @@ Matrix Hill::getD() const {
  */
 bool Hill::setE(const Matrix& E) {
 	Matrix null = Matrix(std::vector<int>(), 0, 0);
-	Matrix temp_E = E;
-	for (int i = 0; i < (temp_E.size(1) * temp_E.size(2)); i++)
-	{
-		temp_E.set(i, mod(temp_E.get(i), 29));
-	}
-	Matrix holder = inv_mod(temp_E);
-	if ((holder.equal(null)) && (E.size(1) == E.size(2)) && (E.size(1) > 1) && (E.size(2) > 1)) {
-		this->D = holder;
-		this->E = temp_E;
+	Matrix temp_E = E.map([this](int x) { return static_cast<int>(mod(x, 29)); });
+	Matrix I = (E.size(1) == E.size(2)) && (E.size(1) > 1) ? inverse(temp_E) : null;
+	if (I.size(1) != 0) {
+		setKeys(temp_E, I);
 		return true;
 	}
 	else
 	{
-		this->D = null;
-		this->E = null;
+		setKeys(null, null);
 		return false;
 	}
 	
@@ -113,21 +345,15 @@ bool Hill::setE(const Matrix& E) {
 */
 bool Hill::setD(const Matrix& D) {
 	Matrix null = Matrix(std::vector<int>(), 0, 0);
-	Matrix temp_D = D;
-	for (int i = 0; i < (temp_D.size(1) * temp_D.size(2)); i++)
-	{
-		temp_D.set(i, mod(temp_D.get(i), 29));
-	}
-	Matrix holder = inv_mod(D);
-	if ((holder.equal(null)) && (D.size(1) == D.size(2)) && (D.size(1) > 1) && (D.size(2) > 1)) {
-		this->D = temp_D;
-		this->E = holder;
+	Matrix temp_D = D.map([this](int x) { return static_cast<int>(mod(x, 29)); });
+	Matrix I = (D.size(1) == D.size(2)) && (D.size(1) > 1) ? inverse(temp_D) : null;
+	if (I.size(1) != 0) {
+		setKeys(I, temp_D);
 		return true;
 	}
 	else
 	{
-		this->D = null;
-		this->E = null;
+		setKeys(null, null);
 		return false;
 	}
 }
@@ -138,121 +364,1179 @@ bool Hill::setD(const Matrix& D) {
  * @return the ciphertext resulting from encrypting the plaintext using the stored encryption matrix.
  */
 std::string Hill::encrypt(const std::string& P) const {
-	Matrix null(std::vector<int>(), 0, 0);
+	return cipher(this->ES, P, 1);
+}
 
-	//integrate mechanism to check for invalid characters
+/**
+ * Encrypt the given plaintext using the given encryption key, an empty string if the encryption key is invalid.
+ * @param P - the plaintext to encrypt
+ * @param E - the key to use to encrypt the plaintext
+ * @return the ciphertext resulting from encrypting the plaintext using the given encryption matrix.
+ */
+std::string Hill::encrypt(const std::string& P, const Matrix& E) {
+	return cipher(schedule(E), P, 1);
+}
 
-	Matrix hidden = this->getE().mult(l2num(P, this->getE().size(1)));
+/**
+ * Decrypt the given ciphertext using the previous set decryption key, an empty string if the decryption key is invalid.
+ * @param C - the ciphertext to decrypt
+ * @return the plaintext resulting from decrypting the ciphertext using the stored decryption matrix.
+ */
+std::string Hill::decrypt(const std::string& C) const{
+	return cipher(this->DS, C, 1);
+}
 
-	for (int i = 0; i < hidden.size(1) * hidden.size(2); i++)
-	{
-		hidden.set(i, mod(hidden.get(i), 29));
-	}
+/**
+ * Decrypt the given ciphertext using the given decryption key, an empty string if the decryption key is invalid.
+ * @param C - the plaintext to encrypt
+ * @param D - the key to use to decrypt the ciphertext
+ * @return the plaintext resulting from decrypting the ciphertext using the given decryption matrix.
+ */
+std::string Hill::decrypt(const std::string& C, const Matrix& D) {
+	return cipher(schedule(D), C, 1);
+}
 
-	return n2let(hidden);
+/**
+ * Encrypt the given plaintext using the previous set encryption key into a buffer supplied by the caller; no memory is allocated for keys up to 256-by-256.
+ * @param P - the plaintext to encrypt
+ * @param length - number of characters in P
+ * @param out - where the ciphertext goes (may be P itself)
+ * @param capacity - number of characters out has room for
+ * @return the number of characters written to out, 0 if the encryption key is invalid, P can't be encrypted or out is too small.
+ */
+std::size_t Hill::encrypt(const char* P, std::size_t length, char* out, std::size_t capacity) const {
+	return cipher(this->ES, P, length, out, capacity);
+}
 
+/**
+ * Decrypt the given ciphertext using the previous set decryption key into a buffer supplied by the caller; no memory is allocated for keys up to 256-by-256.
+ * @param C - the ciphertext to decrypt
+ * @param length - number of characters in C
+ * @param out - where the plaintext goes (may be C itself)
+ * @param capacity - number of characters out has room for
+ * @return the number of characters written to out, 0 if the decryption key is invalid, C can't be decrypted or out is too small.
+ */
+std::size_t Hill::decrypt(const char* C, std::size_t length, char* out, std::size_t capacity) const {
+	return cipher(this->DS, C, length, out, capacity);
+}
 
-	//check if this->E is a valid matrix
-	//check to make sure the string has valid characters
-	//check length of the string 
-	
+/**
+ * Encrypt the given plaintext using the previous set encryption key, splitting the work over several threads; the result is the same as encrypt(P).
+ * @param P - the plaintext to encrypt
+ * @param threads - number of threads to use, 0 for one per core
+ * @return the ciphertext resulting from encrypting the plaintext using the stored encryption matrix, an empty string if the encryption key is invalid.
+ */
+std::string Hill::encryptParallel(const std::string& P, unsigned int threads) const {
+	return cipher(this->ES, P, threads);
+}
 
-	return "";
+/**
+ * Decrypt the given ciphertext using the previous set decryption key, splitting the work over several threads; the result is the same as decrypt(C).
+ * @param C - the ciphertext to decrypt
+ * @param threads - number of threads to use, 0 for one per core
+ * @return the plaintext resulting from decrypting the ciphertext using the stored decryption matrix, an empty string if the decryption key is invalid.
+ */
+std::string Hill::decryptParallel(const std::string& C, unsigned int threads) const {
+	return cipher(this->DS, C, threads);
 }
 
 /**
- * Encrypt the given plaintext using the given encryption key, an empty string if the encryption key is invalid.
- * @param P - the plaintext to encrypt
- * @param E - the key to use to encrypt the plaintext
- * @return the ciphertext resulting from encrypting the plaintext using the given encryption matrix.
+ * Encrypt many plaintexts in one go using the previous set encryption key.  The ciphertexts are written back to back into arena, ciphertext i being
+ * arena.substr(offsets[i], offsets[i + 1] - offsets[i]); arena and offsets keep their capacity, so reusing them across calls saves allocations.
+ * @param P - the plaintexts to encrypt
+ * @param count - number of plaintexts in P
+ * @param arena - receives the ciphertexts; a plaintext that can't be encrypted gets an empty ciphertext, just like encrypt()
+ * @param offsets - receives count + 1 offsets into arena
+ * @return the number of plaintexts that were encrypted.
  */
-std::string Hill::encrypt(const std::string& P, const Matrix& E) {
-	Matrix null(std::vector<int>(), 0, 0);
+std::size_t Hill::encryptBatch(const std::string* P, std::size_t count, std::string& arena, std::vector<std::size_t>& offsets) const {
+	return batch(this->ES, P, count, arena, offsets);
+}
 
-	//integrate mechanism to check for invalid characters
+/**
+ * Decrypt many ciphertexts in one go using the previous set decryption key.  The plaintexts are written back to back into arena, plaintext i being
+ * arena.substr(offsets[i], offsets[i + 1] - offsets[i]); arena and offsets keep their capacity, so reusing them across calls saves allocations.
+ * @param C - the ciphertexts to decrypt
+ * @param count - number of ciphertexts in C
+ * @param arena - receives the plaintexts; a ciphertext that can't be decrypted gets an empty plaintext, just like decrypt()
+ * @param offsets - receives count + 1 offsets into arena
+ * @return the number of ciphertexts that were decrypted.
+ */
+std::size_t Hill::decryptBatch(const std::string* C, std::size_t count, std::string& arena, std::vector<std::size_t>& offsets) const {
+	return batch(this->DS, C, count, arena, offsets);
+}
 
-	Matrix hidden = E.mult(l2num(P, E.size(1)));
+/**
+ * Encrypt or decrypt one text under many keys at once; the text is mapped to numbers only once and all keys of the same size are multiplied with it together.
+ * The caller picks the direction: pass encryption keys to encrypt T, decryption keys to decrypt it.
+ * @param T - the text to encrypt or decrypt
+ * @param keys - the keys to use
+ * @return the result for each key, in the same order; an empty string where encrypt(T, keys[i]) would give one.
+ */
+std::vector<std::string> Hill::cipherMany(const std::string& T, const std::vector<Matrix>& keys) const {
+	std::vector<std::string> result(keys.size());
+	std::size_t length = T.length();
 
-	for (int i = 0; i < hidden.size(1) * hidden.size(2); i++)
-	{
-		hidden.set(i, mod(hidden.get(i), 29));
+	// map T to numbers once for all keys
+	std::vector<unsigned char> p(length);
+	for (std::size_t i = 0; i < length; i++) {
+		p[i] = L2N[static_cast<unsigned char>(T[i])];
+		if (p[i] == BAD) {
+			return result;
+		}
 	}
 
-	return n2let(hidden);
+	std::vector<bool> done(keys.size(), false);
+	for (std::size_t first = 0; first < keys.size(); first++) {
+		unsigned int n = keys[first].size(1);
+		if (done[first] || n == 0 || n != keys[first].size(2) || length % n != 0) {
+			continue;
+		}
 
+		// stack every key of this size on top of each other (row by row, reduced mod 29) into one tall matrix W
+		std::vector<std::size_t> which;
+		std::vector<unsigned char> W;
+		for (std::size_t k = first; k < keys.size(); k++) {
+			if (!done[k] && keys[k].size(1) == n && keys[k].size(2) == n) {
+				W.resize(W.size() + n * n);
+				reduceRows(keys[k], &W[W.size() - n * n]);
+				which.push_back(k);
+				done[k] = true;
+				result[k].resize(length);
+			}
+		}
 
-	//check if this->E is a valid matrix
-	//check to make sure the string has valid characters
-	//check length of the string 
+		// W times the message matrix, one block (column) at a time so the block stays in registers for every key
+		std::size_t rows = W.size() / n;
+		for (std::size_t b = 0; b < length; b += n) {
+			const unsigned char* block = &p[b];
+			for (std::size_t r = 0; r < rows; r++) {
+				const unsigned char* row = &W[r * n];
+				unsigned int sum = 0;
+				for (unsigned int k = 0; k < n; k++) {
+					sum += row[k] * block[k];
+				}
+				result[which[r / n]][b + r % n] = N2L[sum % 29];
+			}
+		}
+	}
+	return result;
+}
 
+/**
+ * Mount a known-plaintext attack against the Hill cipher assuming an n-by-n encryption matrix.  Set E/D to the encryption/decryption key if they can be recovered.
+ * @param P - the plaintexts that correspond to C
+ * @param C - the ciphertexts that correspond to P
+ * @return true if the encryption and decryption keys have been recovered.
+ */
+bool Hill::kpa(const std::vector<std::string>& P, const std::vector<std::string>& C, unsigned int n) {
+	if (n == 0 || P.size() != C.size()) {
+		return false;
+	}
+
+	// n plaintext blocks that are linearly independent mod 29, and their ciphertext blocks, both column-wise;
+	// basis keeps the chosen plaintext blocks in echelon form (pivot 1 at pivots[b]) to test new blocks against
+	std::vector<int> Pn, Cn;
+	std::vector<std::vector<unsigned int> > basis;
+	std::vector<unsigned int> pivots;
+	std::vector<unsigned int> v(n);
+
+	for (std::size_t t = 0; t < P.size() && basis.size() < n; t++) {
+		if (P[t].length() != C[t].length() || P[t].length() % n != 0) {
+			return false;
+		}
+
+		for (std::size_t b = 0; b < P[t].length() && basis.size() < n; b += n) {
+			// reduce the block against the blocks chosen so far
+			for (unsigned int i = 0; i < n; i++) {
+				v[i] = L2N[static_cast<unsigned char>(P[t][b + i])];
+				if (v[i] == BAD || L2N[static_cast<unsigned char>(C[t][b + i])] == BAD) {
+					return false;
+				}
+			}
+			for (std::size_t k = 0; k < basis.size(); k++) {
+				unsigned int f = v[pivots[k]];
+				if (f != 0) {
+					for (unsigned int i = 0; i < n; i++) {
+						v[i] = (v[i] + (29 - f) * basis[k][i]) % 29;
+					}
+				}
+			}
 
-	return "";
+			// anything left means the block adds a new direction
+			unsigned int pivot = 0;
+			while (pivot < n && v[pivot] == 0) {
+				pivot++;
+			}
+			if (pivot == n) {
+				continue;
+			}
+			unsigned int inverse = INV29[v[pivot]];
+			for (unsigned int i = 0; i < n; i++) {
+				v[i] = v[i] * inverse % 29;
+			}
+			basis.push_back(v);
+			pivots.push_back(pivot);
+
+			for (unsigned int i = 0; i < n; i++) {
+				Pn.push_back(L2N[static_cast<unsigned char>(P[t][b + i])]);
+				Cn.push_back(L2N[static_cast<unsigned char>(C[t][b + i])]);
+			}
+		}
+	}
+
+	// not enough independent blocks to pin the key down
+	if (basis.size() < n) {
+		return false;
+	}
+
+	// C = E * P for the chosen blocks, so E = C * P^-1
+	Matrix found = Matrix(Cn, n, n).mult(inv_mod(Matrix(Pn, n, n)));
+	found.transform([this](int x) { return static_cast<int>(mod(x, 29)); });
+	if (!invertible(found)) {
+		return false;
+	}
+
+	// the key has to explain every pair, not just the blocks it was solved from
+	Schedule S = schedule(found);
+	std::vector<char> check;
+	for (std::size_t t = 0; t < P.size(); t++) {
+		if (P[t].length() != C[t].length() || P[t].length() % n != 0) {
+			return false;
+		}
+		check.resize(P[t].length());
+		if (!P[t].empty() && (!translate(S, P[t].data(), P[t].length(), check.data()) || !std::equal(check.begin(), check.end(), C[t].begin()))) {
+			return false;
+		}
+	}
+
+	setKeys(found, inverse(found));
+	return true;
 }
 
 /**
- * Decrypt the given ciphertext using the previous set decryption key, an empty string if the decryption key is invalid.
- * @param C - the ciphertext to decrypt
- * @return the plaintext resulting from decrypting the ciphertext using the stored decryption matrix.
+ * Mount a ciphertext-only attack against the Hill cipher assuming an n-by-n key: try decryption keys on (a sample of) C and keep the one whose plaintext looks most like English.  Set E/D to that key.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @return true if a key was found, false if C can't be attacked (wrong length, bad characters or an unsupported n).
  */
-std::string Hill::decrypt(const std::string& C) const{
+bool Hill::coa(const std::string& C, unsigned int n) {
+	return coaAdopt(coaCandidates(C, n, 1, 0));
+}
+
+/**
+ * Ciphertext-only attack as in coa(), judging candidate plaintexts with the given language model instead of the built-in English letter pairs.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @param model - the language model to score candidate plaintexts with
+ * @return true if a key was found, false if C can't be attacked (wrong length, bad characters, an unsupported n or an empty model).
+ */
+bool Hill::coa(const std::string& C, unsigned int n, const NGramModel& model) {
+	return coaAdopt(coaCandidates(C, n, 1, model, 0));
+}
+
+/**
+ * Ciphertext-only attack as in coa(), but return the best few candidate decryption keys instead of setting E/D.
+ * For n = 2 every one of the 29^4 decryption keys with a non-zero determinant is tried; for larger n the key is found one row at a time
+ * (29^n candidates per row): on one core 4-by-4 takes well under a second, 5-by-5 a few seconds and 6-by-6 a few minutes.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @param k - number of candidates to return
+ * @param threads - number of threads to use, 0 for one per core
+ * @return up to k decryption keys, best first; empty if C can't be attacked.
+ */
+std::vector<Matrix> Hill::coaCandidates(const std::string& C, unsigned int n, unsigned int k, unsigned int threads) const {
+	return coaSearch(C, n, k, nullptr, threads);
+}
+
+/**
+ * Ciphertext-only attack as in coaCandidates(), judging candidate plaintexts with the given language model instead of the built-in English letter pairs.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @param k - number of candidates to return
+ * @param model - the language model to score candidate plaintexts with
+ * @param threads - number of threads to use, 0 for one per core
+ * @return up to k decryption keys, best first; empty if C can't be attacked or the model is empty.
+ */
+std::vector<Matrix> Hill::coaCandidates(const std::string& C, unsigned int n, unsigned int k, const NGramModel& model, unsigned int threads) const {
+	if (model.order() == 0) {
+		return std::vector<Matrix>();
+	}
+	return coaSearch(C, n, k, &model, threads);
+}
+
+/*
+* Makes the best of the candidate decryption keys from a ciphertext-only attack this object's key
+* returns false, leaving the keys alone, if there are none
+*/
+bool Hill::coaAdopt(const std::vector<Matrix>& best) {
+	if (best.empty()) {
+		return false;
+	}
+
+	// candidates are put together to be invertible, but make sure before replacing the keys
+	Matrix E = inverse(best[0]);
+	if (E.size(1) == 0) {
+		return false;
+	}
+	setKeys(E, best[0]);
+	return true;
+}
+
+/*
+* Ciphertext-only attack behind coa() and coaCandidates(): checks C, takes the sample and hands it to coaPairs or coaRows
+* candidate plaintexts are judged with model, or the built-in English letter pairs if model is null
+*/
+std::vector<Matrix> Hill::coaSearch(const std::string& C, unsigned int n, unsigned int k, const NGramModel* model, unsigned int threads) const {
+	std::vector<Matrix> result;
+	if (n < 2 || n > COA_MAX || k == 0 || C.length() % n != 0 || C.length() < 2 * n) {
+		return result;
+	}
+
+	// only the start of a long ciphertext is needed to tell keys apart
+	std::size_t length = std::min<std::size_t>(C.length(), COA_SAMPLE / n * n);
+	std::vector<unsigned char> c(length);
+	for (std::size_t i = 0; i < length; i++) {
+		c[i] = L2N[static_cast<unsigned char>(C[i])];
+		if (c[i] == BAD) {
+			return result;
+		}
+	}
+
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	return n == 2 ? coaPairs(c, k, model, threads) : coaRows(c, n, k, model, threads);
+}
+
+/*
+* Ciphertext-only attack on a 2-by-2 key: scores every invertible decryption key on the (numerical) ciphertext c
+* returns the k best, best first
+*/
+std::vector<Matrix> Hill::coaPairs(const std::vector<unsigned char>& c, unsigned int k, const NGramModel* model, unsigned int threads) {
+	std::vector<Matrix> result;
+	std::size_t blocks = c.size() / 2;
+
+	// each row (x, y) of a decryption key gives the same symbols whatever the other row is, so work out what all
+	// 29 * 29 possible rows give once; a candidate key is then a pair of rows and costs only table lookups to score
+	std::vector<unsigned char> rows(29 * 29 * blocks);
+	for (unsigned int r = 0; r < 29 * 29; r++) {
+		unsigned int x = r / 29, y = r % 29;
+		for (std::size_t i = 0; i < blocks; i++) {
+			rows[r * blocks + i] = static_cast<unsigned char>((x * c[2 * i] + y * c[2 * i + 1]) % 29);
+		}
+	}
+
+	const int* pair = english().pair;
+
+	// threads take the next top row as they finish one, so none of them sits idle while others still have work;
+	// each keeps its own k best and they are merged at the end
+	std::atomic<unsigned int> next(0);
+	std::vector<std::vector<Scored> > heaps(threads);
+	auto work = [&](unsigned int t) {
+		std::vector<unsigned char> plain(2 * blocks);
+		for (unsigned int top = next++; top < 29 * 29; top = next++) {
+			const unsigned char* p0 = &rows[top * blocks];
+			for (unsigned int bottom = 0; bottom < 29 * 29; bottom++) {
+				// skip keys that can't be inverted
+				if ((top / 29 * (bottom % 29) + 29 * 29 - top % 29 * (bottom / 29)) % 29 == 0) {
+					continue;
+				}
+				const unsigned char* p1 = &rows[bottom * blocks];
+				long score = 0;
+				if (model != nullptr) {
+					// put the plaintext back together for the model
+					for (std::size_t i = 0; i < blocks; i++) {
+						plain[2 * i] = p0[i];
+						plain[2 * i + 1] = p1[i];
+					}
+					score = model->score(plain.data(), plain.size());
+				}
+				else {
+					score = pair[p0[0] * 29 + p1[0]];
+					for (std::size_t i = 1; i < blocks; i++) {
+						score += pair[p1[i - 1] * 29 + p0[i]] + pair[p0[i] * 29 + p1[i]];
+					}
+				}
+				Scored candidate = { score, top * 29 * 29 + bottom };
+				offer(heaps[t], k, candidate);
+			}
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < threads; t++) {
+		pool.push_back(std::thread(work, t));
+	}
+	work(0);
+	for (std::size_t t = 0; t < pool.size(); t++) {
+		pool[t].join();
+	}
+
+	std::vector<Scored> all;
+	for (unsigned int t = 0; t < threads; t++) {
+		all.insert(all.end(), heaps[t].begin(), heaps[t].end());
+	}
+	std::sort(all.begin(), all.end(), better);
+	for (std::size_t i = 0; i < all.size() && i < k; i++) {
+		unsigned int top = all[i].key / (29 * 29), bottom = all[i].key % (29 * 29);
+		// column-wise: D(0,0), D(1,0), D(0,1), D(1,1)
+		result.push_back(Matrix(std::vector<int>{ static_cast<int>(top / 29), static_cast<int>(bottom / 29), static_cast<int>(top % 29), static_cast<int>(bottom % 29) }, 2, 2));
+	}
+	return result;
+}
+
+/*
+* Ciphertext-only attack on a 3-by-3 up to COA_MAX-by-COA_MAX key, one row at a time: row i of the decryption key alone decides
+* symbol i of every plaintext block, so each of the 29^n possible rows is scored by how English its symbols' letter frequencies
+* look (by model's single letter values if there is a model), the best rows that together can be inverted are kept, and their
+* order is settled by letter pairs (or model) across the whole plaintext
+* returns the k best decryption keys (orderings of those rows), best first
+*/
+std::vector<Matrix> Hill::coaRows(const std::vector<unsigned char>& c, unsigned int n, unsigned int k, const NGramModel* model, unsigned int threads) {
+	std::vector<Matrix> result;
+	std::size_t blocks = c.size() / n;
+	const English& letters = english();
+
+	// rows are scored by single letters; with a model, by the model's own single letter values
+	std::vector<int> single(letters.single, letters.single + 29);
+	if (model != nullptr && model->order() > 0) {
+		single = model->unigrams();
+	}
+
+	// ciphertext column-wise by position in the block: column j holds symbol j of every block, so stepping a row's
+	// last element by one just adds column n - 1 to the row's symbols
+	std::vector<unsigned char> columns(n * blocks);
+	for (std::size_t i = 0; i < blocks; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			columns[j * blocks + i] = c[i * n + j];
+		}
+	}
+
+	// rows are numbered in base 29 (first element most significant); threads take the next prefix (all but the last
+	// element) as they finish one, and keep their own best rows, which are merged at the end
+	unsigned int prefixes = 1;
+	for (unsigned int j = 1; j < n; j++) {
+		prefixes *= 29;
+	}
+	std::size_t keep = std::max<std::size_t>(4 * n, n + k);
+	std::atomic<unsigned int> next(0);
+	std::vector<std::vector<Scored> > heaps(threads);
+	auto work = [&](unsigned int t) {
+		std::vector<unsigned char> symbols(blocks);
+		std::vector<unsigned int> counts(29);
+		const unsigned char* last = &columns[(n - 1) * blocks];
+		for (unsigned int prefix = next++; prefix < prefixes; prefix = next++) {
+			// symbols for the prefix with last element 0
+			std::fill(symbols.begin(), symbols.end(), 0);
+			unsigned int digits = prefix;
+			for (unsigned int j = n - 1; j-- > 0; digits /= 29) {
+				unsigned int x = digits % 29;
+				const unsigned char* column = &columns[j * blocks];
+				for (std::size_t i = 0; i < blocks; i++) {
+					symbols[i] = static_cast<unsigned char>((symbols[i] + x * column[i]) % 29);
+				}
+			}
+
+			for (unsigned int x = 0; x < 29; x++) {
+				if (x != 0) {
+					// one more of the last column, reduced with a conditional subtract (a plain loop the compiler vectorises)
+					for (std::size_t i = 0; i < blocks; i++) {
+						unsigned int s = symbols[i] + last[i];
+						symbols[i] = static_cast<unsigned char>(s >= 29 ? s - 29 : s);
+					}
+				}
+				else if (prefix == 0) {
+					// the all-zero row can't be part of an invertible key
+					continue;
+				}
+
+				// letter counts times their log-probabilities
+				std::fill(counts.begin(), counts.end(), 0);
+				for (std::size_t i = 0; i < blocks; i++) {
+					counts[symbols[i]]++;
+				}
+				long score = 0;
+				for (unsigned int v = 0; v < 29; v++) {
+					score += static_cast<long>(counts[v]) * single[v];
+				}
+				Scored candidate = { score, prefix * 29 + x };
+				offer(heaps[t], keep, candidate);
+			}
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < threads; t++) {
+		pool.push_back(std::thread(work, t));
+	}
+	work(0);
+	for (std::size_t t = 0; t < pool.size(); t++) {
+		pool[t].join();
+	}
+
+	std::vector<Scored> all;
+	for (unsigned int t = 0; t < threads; t++) {
+		all.insert(all.end(), heaps[t].begin(), heaps[t].end());
+	}
+	std::sort(all.begin(), all.end(), better);
+
+	// take the best rows that are independent of the ones already taken (mod 29, by elimination), until there are n
+	std::vector<std::vector<unsigned int> > chosen, basis;
+	std::vector<unsigned int> pivots;
+	for (std::size_t r = 0; r < all.size() && chosen.size() < n; r++) {
+		std::vector<unsigned int> row(n);
+		unsigned int digits = all[r].key;
+		for (unsigned int j = n; j-- > 0; digits /= 29) {
+			row[j] = digits % 29;
+		}
+
+		std::vector<unsigned int> v = row;
+		for (std::size_t b = 0; b < basis.size(); b++) {
+			unsigned int f = v[pivots[b]];
+			for (unsigned int j = 0; j < n && f != 0; j++) {
+				v[j] = (v[j] + (29 - f) * basis[b][j]) % 29;
+			}
+		}
+		unsigned int pivot = 0;
+		while (pivot < n && v[pivot] == 0) {
+			pivot++;
+		}
+		if (pivot == n) {
+			continue;
+		}
+		unsigned int inverse = INV29[v[pivot]];
+		for (unsigned int j = 0; j < n; j++) {
+			v[j] = v[j] * inverse % 29;
+		}
+		basis.push_back(v);
+		pivots.push_back(pivot);
+		chosen.push_back(row);
+	}
+	if (chosen.size() < n) {
+		return result;
+	}
+
+	// the letter frequencies can't tell which row goes where, letter pairs across the plaintext can: try every order
+	std::vector<unsigned int> order(n);
+	for (unsigned int j = 0; j < n; j++) {
+		order[j] = j;
+	}
+	std::vector<Scored> orders;
+	std::vector<std::vector<unsigned int> > permutations;
+	std::vector<unsigned char> plain(blocks * n);
+	do {
+		for (std::size_t i = 0; i < blocks; i++) {
+			for (unsigned int j = 0; j < n; j++) {
+				const std::vector<unsigned int>& row = chosen[order[j]];
+				unsigned int sum = 0;
+				for (unsigned int x = 0; x < n; x++) {
+					sum += row[x] * c[i * n + x];
+				}
+				plain[i * n + j] = static_cast<unsigned char>(sum % 29);
+			}
+		}
+		long score = 0;
+		if (model != nullptr) {
+			score = model->score(plain.data(), plain.size());
+		}
+		else {
+			for (std::size_t i = 1; i < plain.size(); i++) {
+				score += letters.pair[plain[i - 1] * 29 + plain[i]];
+			}
+		}
+		Scored candidate = { score, static_cast<unsigned int>(permutations.size()) };
+		orders.push_back(candidate);
+		permutations.push_back(order);
+	} while (std::next_permutation(order.begin(), order.end()));
+	std::sort(orders.begin(), orders.end(), better);
+
+	for (std::size_t i = 0; i < orders.size() && i < k; i++) {
+		const std::vector<unsigned int>& p = permutations[orders[i].key];
+		std::vector<int> d(n * n);
+		for (unsigned int r = 0; r < n; r++) {
+			for (unsigned int j = 0; j < n; j++) {
+				d[j * n + r] = static_cast<int>(chosen[p[r]][j]);
+			}
+		}
+		result.push_back(Matrix(d, n, n));
+	}
+	return result;
+}
+
+/*
+* Returns the vector of number
+* convert the string of characters in s to the equivalent numerical values using our 29 character alphabet and put in matrix suitable for n-by-n encryption matrix
+* returns a 0-by-0 matrix if s has a character outside the alphabet or doesn't fill whole blocks of n
+*/
+Matrix Hill::l2num(const std::string& s, unsigned int n) const {
 	Matrix null(std::vector<int>(), 0, 0);
+	std::size_t length = s.length();
 
-	//integrate mechanism to check for invalid characters
-	Matrix hidden;
-	hidden = this->getD().mult(l2num(C, this->getD().size(1)));
+	// the text has to fill up whole n-character blocks
+	if (n == 0 || length % n != 0) {
+		return null;
+	}
 
-	for (int i = 0; i < hidden.size(1) * hidden.size(2); i++)
-	{
-		hidden.set(i, mod(hidden.get(i), 29));
+	// sized up front so every value is written straight into place
+	std::vector<int> result(length);
+	const char* in = s.data();
+	std::size_t i = 0;
+
+#if defined(__SSE2__)
+	// 16 characters at a time while there are enough left
+	for (; i + 16 <= length; i += 16) {
+		if (!l2num16(in + i, &result[i])) {
+			return null;
+		}
 	}
+#endif
 
-	return n2let(hidden);
+	// the rest one at a time through the table
+	for (; i < length; i++) {
+		unsigned char value = L2N[static_cast<unsigned char>(in[i])];
+		if (value == BAD) {
+			return null;
+		}
+		result[i] = value;
+	}
 
+	// converting the vector to Matrix
+	return Matrix(result, n, length / n);
+}
 
-	//check if this->E is a valid matrix
-	//check to make sure the string has valid characters
-	//check length of the string 
+/*
+* Converts the matrix to a string of characters using our 29 character alphabet
+* values outside 0-28 are skipped
+*/
+std::string Hill::n2let(const Matrix& A) const {
+	std::size_t length = A.size(1) * A.size(2);
+	const int* in = A.data();
+	std::string result(length, ' ');
+	std::size_t written = 0;
+	std::size_t i = 0;
 
+#if defined(__SSE2__)
+	// 16 values at a time, as long as nothing has been skipped yet (so input and output stay lined up)
+	for (; i + 16 <= length; i += 16) {
+		if (!n2let16(in + i, &result[i])) {
+			break;
+		}
+	}
+	written = i;
+#endif
 
-	return "";
+	// the rest one at a time through the table
+	for (; i < length; i++) {
+		if (in[i] >= 0 && in[i] <= 28) {
+			result[written++] = N2L[in[i]];
+		}
+	}
+
+	result.resize(written);
+	return result;
 }
 
-/**
- * Decrypt the given ciphertext using the given decryption key, an empty string if the decryption key is invalid.
- * @param C - the plaintext to encrypt
- * @param D - the key to use to decrypt the ciphertext
- * @return the plaintext resulting from decrypting the ciphertext using the given decryption matrix.
- */
-std::string Hill::decrypt(const std::string& C, const Matrix& D) {
+/*
+* Calculates the determinant of a square matrix mod 29 by fraction-free elimination
+* returns a value in [0, 29), or -1 if A isn't square
+*/
+int Hill::det_mod(const Matrix& A) const {
+	unsigned int n = A.size(1);
+	if (n != A.size(2)) {
+		return -1;
+	}
+
+	// reduced copy, row by row
+	std::vector<unsigned int> M(n * n);
+	const int* a = A.data();
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			M[i * n + j] = mod(a[j * n + i], 29);
+		}
+	}
+
+	// row k becomes p * row k - f * row j; no division, but every such step multiplies the determinant by p,
+	// which is tracked in scale and divided out once at the end
+	unsigned int det = 1;
+	unsigned int scale = 1;
+	for (unsigned int j = 0; j < n; j++) {
+		unsigned int r = j;
+		while (r < n && M[r * n + j] == 0) {
+			r++;
+		}
+		// no pivot: singular, and there's no need to look any further
+		if (r == n) {
+			return 0;
+		}
+		// a row swap flips the sign
+		if (r != j) {
+			std::swap_ranges(M.begin() + r * n, M.begin() + (r + 1) * n, M.begin() + j * n);
+			det = 29 - det;
+		}
+
+		const unsigned int* pivot = &M[j * n];
+		unsigned int p = pivot[j];
+		det = det * p % 29;
+		for (unsigned int k = j + 1; k < n; k++) {
+			unsigned int f = M[k * n + j];
+			if (f == 0) {
+				continue;
+			}
+			unsigned int* row = &M[k * n];
+			for (unsigned int c = j; c < n; c++) {
+				row[c] = (p * row[c] + (29 - f) * pivot[c]) % 29;
+			}
+			scale = scale * p % 29;
+		}
+	}
+	return static_cast<int>(det * INV29[scale] % 29);
+}
+
+/*
+* Returns the greatest common divisor of a and b
+*/
+unsigned int Hill::gcd(unsigned int a, unsigned int b) {
+	while (b != 0) {
+		unsigned int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/*
+* Returns true if K is a square matrix that can be inverted mod 29, i.e. its determinant shares no factor with 29
+*/
+bool Hill::invertible(const Matrix& K) const {
+	int det = det_mod(K);
+	return K.size(1) != 0 && det >= 0 && gcd(static_cast<unsigned int>(det), 29) == 1;
+}
+
+/*
+* Calculates the inverse of a matrix over Z_{29} by Gauss-Jordan elimination with row swaps
+* returns a 0-by-0 matrix if A isn't square or isn't invertible mod 29
+*/
+Matrix Hill::inv_mod(const Matrix& A) const {
 	Matrix null(std::vector<int>(), 0, 0);
+	unsigned int n = A.size(1);
+	if (n == 0 || n != A.size(2)) {
+		return null;
+	}
 
-	//integrate mechanism to check for invalid characters
+	// [A | I] in one flat buffer, row by row, so row operations run over contiguous memory
+	std::size_t w = 2 * n;
+	std::vector<unsigned int> M(n * w, 0);
+	const int* a = A.data();
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			M[i * w + j] = mod(a[j * n + i], 29);
+		}
+		M[i * w + n + i] = 1;
+	}
 
-	Matrix hidden = D.mult(l2num(C, D.size(1)));
+	// rows are only reduced mod 29 when they become the pivot row; until then they just pile up
+	// additions of at most 28 * 28 each, at most one per column, which can't overflow 32 bits
+	for (unsigned int j = 0; j < n; j++) {
+		// any row at or below j with a non-zero entry in column j will do as pivot
+		unsigned int r = j;
+		while (r < n && M[r * w + j] % 29 == 0) {
+			r++;
+		}
+		// nothing left to pivot on means the matrix is singular; no point going any further
+		if (r == n) {
+			return null;
+		}
+		if (r != j) {
+			std::swap_ranges(M.begin() + r * w, M.begin() + (r + 1) * w, M.begin() + j * w);
+		}
+
+		// scale the pivot row so the pivot becomes 1 (everything left of column j is already 0)
+		unsigned int* pivot = &M[j * w];
+		unsigned int inverse = INV29[pivot[j] % 29];
+		for (std::size_t c = j; c < w; c++) {
+			pivot[c] = pivot[c] % 29 * inverse % 29;
+		}
+
+		// clear column j from every other row by adding (29 - f) times the pivot row
+		for (unsigned int k = 0; k < n; k++) {
+			unsigned int f = M[k * w + j] % 29;
+			if (k == j || f == 0) {
+				continue;
+			}
+			unsigned int g = 29 - f;
+			unsigned int* row = &M[k * w];
+			for (std::size_t c = j; c < w; c++) {
+				row[c] += g * pivot[c];
+			}
+		}
+	}
+
+	// the right half is now the inverse; reduce it and store it column-wise
+	std::vector<int> inv(n * n);
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			inv[j * n + i] = M[i * w + n + j] % 29;
+		}
+	}
+	return Matrix(inv, n, n);
+}
 
-	for (int i = 0; i < hidden.size(1) * hidden.size(2); i++)
+/*
+* Returns the inverse of key K mod 29, a 0-by-0 matrix if K isn't invertible
+* inverses of keys seen before come out of the process-wide cache; new ones are checked, inverted and added to it
+*/
+Matrix Hill::inverse(const Matrix& K) const {
+	InverseCache& cache = inverseCache();
+	std::uint64_t hash = hashKey(K);
 	{
-		hidden.set(i, mod(hidden.get(i), 29));
+		std::lock_guard<std::mutex> guard(cache.lock);
+		std::unordered_map<std::uint64_t, std::list<InverseCache::Entry>::iterator>::iterator found = cache.index.find(hash);
+		if (found != cache.index.end() && found->second->key.equal(K)) {
+			// move it to the front so it's the last to go
+			cache.entries.splice(cache.entries.begin(), cache.entries, found->second);
+			cache.hits++;
+			return found->second->inverse;
+		}
+		cache.misses++;
 	}
 
-	return n2let(hidden);
+	// invert outside the lock so other threads aren't held up; only keys that turn out to be invertible are kept
+	Matrix null(std::vector<int>(), 0, 0);
+	if (!invertible(K)) {
+		return null;
+	}
+	Matrix inv = inv_mod(K);
 
+	std::lock_guard<std::mutex> guard(cache.lock);
+	if (cache.capacity == 0) {
+		return inv;
+	}
+	// another thread may have added this key (or one with the same hash) in the meantime; the newest one wins
+	std::unordered_map<std::uint64_t, std::list<InverseCache::Entry>::iterator>::iterator found = cache.index.find(hash);
+	if (found != cache.index.end()) {
+		cache.entries.erase(found->second);
+	}
+	InverseCache::Entry entry = { hash, K, inv };
+	cache.entries.push_front(entry);
+	cache.index[hash] = cache.entries.begin();
+	cache.trim();
+	return inv;
+}
 
-	//check if this->E is a valid matrix
-	//check to make sure the string has valid characters
-	//check length of the string 
+/**
+ * Sets how many keys the process-wide cache of key inverses holds; the least recently used ones are dropped once it's full.
+ * @param capacity - number of keys to keep, 0 to turn the cache off
+ */
+void Hill::setInverseCacheCapacity(std::size_t capacity) {
+	InverseCache& cache = inverseCache();
+	std::lock_guard<std::mutex> guard(cache.lock);
+	cache.capacity = capacity;
+	cache.trim();
+}
 
+/**
+ * Returns how many keys the process-wide cache of key inverses holds at most.
+ * @return the capacity of the cache, 0 if it is turned off.
+ */
+std::size_t Hill::inverseCacheCapacity() {
+	InverseCache& cache = inverseCache();
+	std::lock_guard<std::mutex> guard(cache.lock);
+	return cache.capacity;
+}
 
-	return "";
+/**
+ * Returns how many key setups found their inverse in the process-wide cache since the program started.
+ * @return the number of cache hits.
+ */
+std::size_t Hill::inverseCacheHits() {
+	InverseCache& cache = inverseCache();
+	std::lock_guard<std::mutex> guard(cache.lock);
+	return cache.hits;
 }
 
 /**
- * Mount a known-plaintext attack against the Hill cipher assuming an n-by-n encryption matrix.  Set E/D to the encryption/decryption key if they can be recovered.
- * @param P - the plaintexts that correspond to C
- * @param C - the ciphertexts that correspond to P
- * @return true if the encryption and decryption keys have been recovered.
+ * Returns how many key setups had to work out their inverse since the program started.
+ * @return the number of cache misses.
  */
-bool Hill::kpa(const std::vector<std::string>& P, const std::vector<std::string>& C, unsigned int n) {
-	return false;
+std::size_t Hill::inverseCacheMisses() {
+	InverseCache& cache = inverseCache();
+	std::lock_guard<std::mutex> guard(cache.lock);
+	return cache.misses;
+}
+
+/*
+* Sets E and D (which must be consistent, or both 0-by-0) and rebuilds their schedules
+*/
+void Hill::setKeys(const Matrix& E, const Matrix& D) {
+	this->E = E;
+	this->D = D;
+	this->ES = schedule(E);
+	this->DS = schedule(D);
 }
 
+/*
+* Lays out key K for translate(); a non-square K gives a schedule with n = 0, which translates nothing
+*/
+Hill::Schedule Hill::schedule(const Matrix& K) {
+	Schedule S;
+	S.n = 0;
+
+	if (K.size(1) == 0 || K.size(1) != K.size(2)) {
+		return S;
+	}
+
+	// row by row, reduced mod 29, so each output symbol is one contiguous dot product
+	S.n = K.size(1);
+	S.K.resize(S.n * S.n);
+	reduceRows(K, S.K.data());
+
+	// a 2-by-2 key only has 29 * 29 possible blocks, so work them all out now and just look them up later
+	if (S.n == 2) {
+		S.digraph.resize(2 * 29 * 29);
+		for (unsigned int a = 0; a < 29; a++) {
+			for (unsigned int b = 0; b < 29; b++) {
+				unsigned int block = a * 29 + b;
+				S.digraph[2 * block] = N2L[(S.K[0] * a + S.K[1] * b) % 29];
+				S.digraph[2 * block + 1] = N2L[(S.K[2] * a + S.K[3] * b) % 29];
+			}
+		}
+	}
+
+	// up to 16-by-16: for each key column k, the column times each of the 29 values p_k, one 16 byte lane per value
+	// a block is then the sum of n of these lanes, with no multiplications at all
+	else if (S.n <= LANES) {
+		S.columns.resize(S.n * 29 * LANES);
+		for (unsigned int k = 0; k < S.n; k++) {
+			for (unsigned int v = 0; v < 29; v++) {
+				unsigned char* lane = &S.columns[(k * 29 + v) * LANES];
+				for (unsigned int i = 0; i < S.n; i++) {
+					lane[i] = static_cast<unsigned char>(S.K[i * S.n + k] * v % 29);
+				}
+			}
+		}
+	}
+	return S;
+}
+
+/*
+* Writes square key K (n-by-n) row by row, reduced mod 29, to the n * n bytes at out
+*/
+void Hill::reduceRows(const Matrix& K, unsigned char* out) {
+	unsigned int n = K.size(1);
+	const int* k = K.data();
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			int value = k[j * n + i] % 29;
+			out[i * n + j] = static_cast<unsigned char>(value < 0 ? value + 29 : value);
+		}
+	}
+}
+
+/*
+* Translates (encrypts or decrypts) T with the key in schedule S, using up to the given number of threads (0 for one per core)
+* returns an empty string if S has no key, T doesn't fill whole blocks or T has a character outside the alphabet
+*/
+std::string Hill::cipher(const Schedule& S, const std::string& T, unsigned int threads) const {
+	unsigned int n = S.n;
+
+	// there has to be a key and T has to be whole blocks
+	if (n == 0 || T.length() % n != 0) {
+		return "";
+	}
+
+	// every thread gets at least PARALLEL_MIN characters, otherwise starting it costs more than it saves
+	std::size_t blocks = T.length() / n;
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threads = static_cast<unsigned int>(std::min<std::size_t>(threads, T.length() / PARALLEL_MIN + 1));
+
+	// each thread writes its own block-aligned slice of the output
+	std::string result(T.length(), ' ');
+	std::size_t per = (blocks + threads - 1) / threads * n;
+	std::vector<char> ok(threads, 0);
+	std::vector<std::thread> pool;
+
+	for (unsigned int t = 1; t < threads; t++) {
+		std::size_t begin = std::min(T.length(), t * per);
+		std::size_t end = std::min(T.length(), begin + per);
+		pool.push_back(std::thread([&S, &T, &result, &ok, t, begin, end]() {
+			ok[t] = translate(S, T.data() + begin, end - begin, &result[begin]);
+		}));
+	}
+
+	// the first slice is done on this thread
+	ok[0] = translate(S, T.data(), std::min(T.length(), per), &result[0]);
+
+	for (std::size_t t = 0; t < pool.size(); t++) {
+		pool[t].join();
+	}
+
+	// a bad character anywhere spoils the whole text
+	for (unsigned int t = 0; t < threads; t++) {
+		if (!ok[t]) {
+			return "";
+		}
+	}
+	return result;
+}
+
+/*
+* Translates length characters of T with the key in schedule S into out, which has room for capacity characters
+* returns the number of characters written, 0 if S has no key, T isn't whole blocks or has a bad character, or out is too small
+*/
+std::size_t Hill::cipher(const Schedule& S, const char* T, std::size_t length, char* out, std::size_t capacity) {
+	if (S.n == 0 || length % S.n != 0 || capacity < length) {
+		return 0;
+	}
+	return translate(S, T, length, out) ? length : 0;
+}
+
+/*
+* Translates count texts with the key in schedule S into arena (see encryptBatch), all blocks of all texts in one pass
+* returns the number of texts that were translated
+*/
+std::size_t Hill::batch(const Schedule& S, const std::string* T, std::size_t count, std::string& arena, std::vector<std::size_t>& offsets) {
+	unsigned int n = S.n;
+	arena.clear();
+	offsets.assign(1, 0);
+
+	// lay every text that is whole blocks out back to back
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		if (n != 0 && T[i].length() % n == 0) {
+			total += T[i].length();
+		}
+	}
+	arena.reserve(total);
+	std::size_t translated = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		if (n != 0 && T[i].length() % n == 0) {
+			arena.append(T[i]);
+			translated++;
+		}
+		offsets.push_back(arena.length());
+	}
+
+	// blocks never straddle two texts, so the whole arena can go through the kernel at once (in place)
+	if (arena.empty() || translate(S, &arena[0], arena.length(), &arena[0])) {
+		return translated;
+	}
+
+	// something had a bad character: redo text by text, dropping the ones that fail
+	arena.clear();
+	translated = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		std::size_t begin = arena.length();
+		if (n != 0 && T[i].length() % n == 0) {
+			arena.append(T[i]);
+			if (translate(S, &arena[begin], T[i].length(), &arena[begin])) {
+				translated++;
+			}
+			else {
+				arena.resize(begin);
+			}
+		}
+		offsets[i + 1] = arena.length();
+	}
+	return translated;
+}
+
+
+/*
+* Translates length characters (whole blocks) of in with the key in schedule S and writes them to out (which may be in)
+* each block is read, mapped to numbers, multiplied by the key, reduced mod 29 and written back as characters in one go
+* returns false if a character is outside the alphabet (out is then only partly written)
+*/
+bool Hill::translate(const Schedule& S, const char* in, std::size_t length, char* out) {
+	unsigned int n = S.n;
+	const unsigned char* K = S.K.data();
+
+	// numerical values of the current block; only very large keys need more room than the stack buffer
+	unsigned char local[256];
+	std::vector<unsigned char> large;
+	unsigned char* p = local;
+	if (n > sizeof(local)) {
+		large.resize(n);
+		p = large.data();
+	}
+
+	// 2-by-2 keys: one table lookup per block
+	if (!S.digraph.empty()) {
+		const char* table = S.digraph.data();
+		for (std::size_t b = 0; b < length; b += 2) {
+			unsigned char first = L2N[static_cast<unsigned char>(in[b])];
+			unsigned char second = L2N[static_cast<unsigned char>(in[b + 1])];
+			if (first == BAD || second == BAD) {
+				return false;
+			}
+			const char* block = table + 2 * (first * 29 + second);
+			out[b] = block[0];
+			out[b + 1] = block[1];
+		}
+		return true;
+	}
+
+	// up to 16-by-16: add up one precomputed lane per key column, keeping every lane below 29 as we go
+	if (!S.columns.empty()) {
+		const unsigned char* table = S.columns.data();
+		unsigned char sum[LANES];
+		for (std::size_t b = 0; b < length; b += n) {
+#if defined(__SSE2__)
+			__m128i acc = _mm_setzero_si128();
+			__m128i modulus = _mm_set1_epi8(29);
+#else
+			std::memset(sum, 0, sizeof(sum));
+#endif
+			for (unsigned int k = 0; k < n; k++) {
+				unsigned char value = L2N[static_cast<unsigned char>(in[b + k])];
+				if (value == BAD) {
+					return false;
+				}
+				const unsigned char* lane = table + (k * 29 + value) * LANES;
+#if defined(__SSE2__)
+				// both are below 29, so if the sum is 29 or more taking 29 off leaves the smaller (unsigned) byte
+				acc = _mm_add_epi8(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(lane)));
+				acc = _mm_min_epu8(acc, _mm_sub_epi8(acc, modulus));
+#else
+				for (unsigned int i = 0; i < LANES; i++) {
+					unsigned int s = sum[i] + lane[i];
+					sum[i] = static_cast<unsigned char>(s >= 29 ? s - 29 : s);
+				}
+#endif
+			}
+
+			// all of in's block has been read, so out may overwrite it now
+#if defined(__SSE2__)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(sum), letters16(acc));
+			std::memcpy(out + b, sum, n);
+#else
+			for (unsigned int i = 0; i < n; i++) {
+				out[b + i] = N2L[sum[i]];
+			}
+#endif
+		}
+		return true;
+	}
+
+	for (std::size_t b = 0; b < length; b += n) {
+		// map the block to numbers first so out may overwrite in
+		for (unsigned int k = 0; k < n; k++) {
+			unsigned char value = L2N[static_cast<unsigned char>(in[b + k])];
+			if (value == BAD) {
+				return false;
+			}
+			p[k] = value;
+		}
+
+		// row i of the key times the block gives output symbol i; n * 28 * 28 fits easily in 32 bits
+		for (unsigned int i = 0; i < n; i++) {
+			const unsigned char* row = K + i * n;
+			unsigned int sum = 0;
+			for (unsigned int k = 0; k < n; k++) {
+				sum += row[k] * p[k];
+			}
+			out[b + i] = N2L[sum % 29];
+		}
+	}
+	return true;
+}
@@ -1,14 +1,16 @@
 #ifndef _HILL_HPP_
 #define _HILL_HPP_
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 #include <vector>
 
 #include "Matrix.hpp"
+#include "NGramModel.hpp"
 
 /**
- * A C++ class to perform encryption/decryption and cryptanalysis using/of the Hill cipher with a 29 character alphabet.
+ * A C++ class to perform encryption/decryption and cryptanalysis using/of the Hill cipher with a 29 character alphabet (BasicHill does other alphabets, without the cryptanalysis).
  */
 class Hill
 {
@@ -88,6 +90,73 @@ std::string decrypt(const std::string& C) const;
  */
 std::string decrypt(const std::string& C, const Matrix& D);
 
+/**
+ * Encrypt the given plaintext using the previous set encryption key into a buffer supplied by the caller; no memory is allocated for keys up to 256-by-256.
+ * @param P - the plaintext to encrypt
+ * @param length - number of characters in P
+ * @param out - where the ciphertext goes (may be P itself)
+ * @param capacity - number of characters out has room for
+ * @return the number of characters written to out, 0 if the encryption key is invalid, P can't be encrypted or out is too small.
+ */
+std::size_t encrypt(const char* P, std::size_t length, char* out, std::size_t capacity) const;
+
+/**
+ * Decrypt the given ciphertext using the previous set decryption key into a buffer supplied by the caller; no memory is allocated for keys up to 256-by-256.
+ * @param C - the ciphertext to decrypt
+ * @param length - number of characters in C
+ * @param out - where the plaintext goes (may be C itself)
+ * @param capacity - number of characters out has room for
+ * @return the number of characters written to out, 0 if the decryption key is invalid, C can't be decrypted or out is too small.
+ */
+std::size_t decrypt(const char* C, std::size_t length, char* out, std::size_t capacity) const;
+
+/**
+ * Encrypt the given plaintext using the previous set encryption key, splitting the work over several threads; the result is the same as encrypt(P).
+ * @param P - the plaintext to encrypt
+ * @param threads - number of threads to use, 0 for one per core
+ * @return the ciphertext resulting from encrypting the plaintext using the stored encryption matrix, an empty string if the encryption key is invalid.
+ */
+std::string encryptParallel(const std::string& P, unsigned int threads = 0) const;
+
+/**
+ * Decrypt the given ciphertext using the previous set decryption key, splitting the work over several threads; the result is the same as decrypt(C).
+ * @param C - the ciphertext to decrypt
+ * @param threads - number of threads to use, 0 for one per core
+ * @return the plaintext resulting from decrypting the ciphertext using the stored decryption matrix, an empty string if the decryption key is invalid.
+ */
+std::string decryptParallel(const std::string& C, unsigned int threads = 0) const;
+
+/**
+ * Encrypt many plaintexts in one go using the previous set encryption key.  The ciphertexts are written back to back into arena, ciphertext i being
+ * arena.substr(offsets[i], offsets[i + 1] - offsets[i]); arena and offsets keep their capacity, so reusing them across calls saves allocations.
+ * @param P - the plaintexts to encrypt
+ * @param count - number of plaintexts in P
+ * @param arena - receives the ciphertexts; a plaintext that can't be encrypted gets an empty ciphertext, just like encrypt()
+ * @param offsets - receives count + 1 offsets into arena
+ * @return the number of plaintexts that were encrypted.
+ */
+std::size_t encryptBatch(const std::string* P, std::size_t count, std::string& arena, std::vector<std::size_t>& offsets) const;
+
+/**
+ * Decrypt many ciphertexts in one go using the previous set decryption key.  The plaintexts are written back to back into arena, plaintext i being
+ * arena.substr(offsets[i], offsets[i + 1] - offsets[i]); arena and offsets keep their capacity, so reusing them across calls saves allocations.
+ * @param C - the ciphertexts to decrypt
+ * @param count - number of ciphertexts in C
+ * @param arena - receives the plaintexts; a ciphertext that can't be decrypted gets an empty plaintext, just like decrypt()
+ * @param offsets - receives count + 1 offsets into arena
+ * @return the number of ciphertexts that were decrypted.
+ */
+std::size_t decryptBatch(const std::string* C, std::size_t count, std::string& arena, std::vector<std::size_t>& offsets) const;
+
+/**
+ * Encrypt or decrypt one text under many keys at once; the text is mapped to numbers only once and all keys of the same size are multiplied with it together.
+ * The caller picks the direction: pass encryption keys to encrypt T, decryption keys to decrypt it.
+ * @param T - the text to encrypt or decrypt
+ * @param keys - the keys to use
+ * @return the result for each key, in the same order; an empty string where encrypt(T, keys[i]) would give one.
+ */
+std::vector<std::string> cipherMany(const std::string& T, const std::vector<Matrix>& keys) const;
+
 /**
  * Mount a known-plaintext attack against the Hill cipher assuming an n-by-n encryption matrix.  Set E/D to the encryption/decryption key if they can be recovered.
  * @param P - the plaintexts that correspond to C
@@ -95,6 +164,71 @@ std::string decrypt(const std::string& C, const Matrix& D);
  * @return true if the encryption and decryption keys have been recovered.
  */
 bool kpa(const std::vector<std::string>& P, const std::vector<std::string>& C, unsigned int n);
+
+/**
+ * Mount a ciphertext-only attack against the Hill cipher assuming an n-by-n key: try decryption keys on (a sample of) C and keep the one whose plaintext looks most like English.  Set E/D to that key.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @return true if a key was found, false if C can't be attacked (wrong length, bad characters or an unsupported n).
+ */
+bool coa(const std::string& C, unsigned int n);
+
+/**
+ * Ciphertext-only attack as in coa(), but return the best few candidate decryption keys instead of setting E/D.
+ * For n = 2 every one of the 29^4 decryption keys with a non-zero determinant is tried; for larger n the key is found one row at a time
+ * (29^n candidates per row): on one core 4-by-4 takes well under a second, 5-by-5 a few seconds and 6-by-6 a few minutes.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @param k - number of candidates to return
+ * @param threads - number of threads to use, 0 for one per core
+ * @return up to k decryption keys, best first; empty if C can't be attacked.
+ */
+std::vector<Matrix> coaCandidates(const std::string& C, unsigned int n, unsigned int k, unsigned int threads = 0) const;
+
+/**
+ * Ciphertext-only attack as in coa(), judging candidate plaintexts with the given language model instead of the built-in English letter pairs.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @param model - the language model to score candidate plaintexts with
+ * @return true if a key was found, false if C can't be attacked (wrong length, bad characters, an unsupported n or an empty model).
+ */
+bool coa(const std::string& C, unsigned int n, const NGramModel& model);
+
+/**
+ * Ciphertext-only attack as in coaCandidates(), judging candidate plaintexts with the given language model instead of the built-in English letter pairs.
+ * @param C - the ciphertext
+ * @param n - size of the key, 2 up to 6
+ * @param k - number of candidates to return
+ * @param model - the language model to score candidate plaintexts with
+ * @param threads - number of threads to use, 0 for one per core
+ * @return up to k decryption keys, best first; empty if C can't be attacked or the model is empty.
+ */
+std::vector<Matrix> coaCandidates(const std::string& C, unsigned int n, unsigned int k, const NGramModel& model, unsigned int threads = 0) const;
+
+/**
+ * Sets how many keys the process-wide cache of key inverses holds; the least recently used ones are dropped once it's full.
+ * @param capacity - number of keys to keep, 0 to turn the cache off
+ */
+static void setInverseCacheCapacity(std::size_t capacity);
+
+/**
+ * Returns how many keys the process-wide cache of key inverses holds at most.
+ * @return the capacity of the cache, 0 if it is turned off.
+ */
+static std::size_t inverseCacheCapacity();
+
+/**
+ * Returns how many key setups found their inverse in the process-wide cache since the program started.
+ * @return the number of cache hits.
+ */
+static std::size_t inverseCacheHits();
+
+/**
+ * Returns how many key setups had to work out their inverse since the program started.
+ * @return the number of cache misses.
+ */
+static std::size_t inverseCacheMisses();
+
 /*
 * Testing out the private method
 */
@@ -115,128 +249,147 @@ Matrix privateIdentityMatrix(unsigned int size) {
 	return identityMatrix(size);
 }
 
+/*
+* Testing out the private method
+*/
+int privateDetMod(const Matrix& A) const {
+	return det_mod(A);
+}
+
 private:
 	Matrix D; //current decryption key; must be consistent with E
 	Matrix E; //current encryption key; must be consistent with D
-	//multiplicative inverses over Z_{29}; e.g., ZI29[1] = 15 is multiplicative inverse of 2. 
-	const std::vector<int> ZI29 = { 1,15,10,22,6,5,25,11,13,3,8,17,9,27,2,20,12,21,26,16,18,4,24,23,7,19,14,28 };
+
+	/*
+	* A key laid out for translate(): n-by-n, reduced mod 29 and stored row by row as bytes
+	*/
+	struct Schedule {
+		unsigned int n; //block size, 0 if there is no usable key
+		std::vector<unsigned char> K; //key elements, row by row
+		std::vector<char> digraph; //2-by-2 keys only: the 2 output characters for each of the 29 * 29 input blocks
+		std::vector<unsigned char> columns; //3-by-3 up to LANES-by-LANES keys only: column k times value v (mod 29) at lane k * 29 + v
+	};
+
+	//width of a lane in Schedule::columns, and so the largest key that gets column tables
+	static const unsigned int LANES = 16;
+	Schedule DS; //schedule for D
+	Schedule ES; //schedule for E
+
+	//smallest number of characters worth giving a thread of its own
+	static const std::size_t PARALLEL_MIN = 1 << 14;
+
+	//most ciphertext characters a ciphertext-only attack looks at
+	static const std::size_t COA_SAMPLE = 512;
+	//largest key a ciphertext-only attack will go after
+	static const unsigned int COA_MAX = 6;
 
 	//YOU ARE FREE TO IMPLEMENT THESE METHODS AND/OR ADD YOUR OWN
 	/*
 	* Returns the vector of number
 	* convert the string of characters in s to the equivalent numerical values using our 29 character alphabet and put in matrix suitable for n-by-n encryption matrix
 	* MODIFIED: changed the value to return a vector
+	* returns a 0-by-0 matrix if s has a character outside the alphabet or doesn't fill whole blocks of n
 	*/
-	Matrix l2num(const std::string& s, unsigned int n) const {
-		std::vector<int> result;
-
-		// Traversing through the vector to identify characters
-		for (int i = 0; i < s.length(); i++) {
-			// If it is a letter (A-Z), use ASCII static casting conversion
-			if (s.at(i) >= 'A' && s.at(i) <= 'Z') {
-				// EXAMPLE: ASCII for A = 65. 65-65 = 0, which is what A corresponds to. This will be pushed
-				result.push_back(static_cast<int>(s.at(i)) - 65);
-			}
-
-			// otherwise, if a period, manually set 26
-			else if (s.at(i) == '.') {
-				result.push_back(26);
-			}
-
-			// otherwise, if a question mark, manually set 27
-			else if (s.at(i) == '?') {
-				result.push_back(27);
-			}
-
-			// otherwise, if a space, manually set 28
-			else if (s.at(i) == ' ') {
-				result.push_back(28);
-			}
-		}
-		// converting the vector to Matrix
-		Matrix final(result, n, s.length() / n);
-		//now, return this Matrix
-		return final;
-	}
+	Matrix l2num(const std::string& s, unsigned int n) const;
 	
 	/*
 	* Converts the matrix to a string of characters using our 29 character alphabet
 	* MODIFIED: returns a string object
 	* uses similar logic to l2num, except reversed.
 	*/
-	std::string n2let(const Matrix & A) const {
-		std::string result;
-		// Nested loop to traverse through the matrix of numbers
-		for (int i = 0; i < (A.size(1) * A.size(2)); i++) {
-
-				// If the element is within 0 and 25
-				if (A.get(i) >= 0 && A.get(i) <= 25) {
-					result.push_back(static_cast<char>(A.get(i) + 65));
-				}
-				else if (A.get(i) == 26) {
-					result.push_back('.');
-				}
-				else if (A.get(i) == 27) {
-					result.push_back('?');
-				}
-				else if (A.get(i) == 28) {
-					result.push_back(' ');
-				}
-		}
-		return result;
-	}
+	std::string n2let(const Matrix & A) const;
 
 	/*
-	* Calculates the invese of a matrix
-	* ps ~this function killed me
+	* Sets E and D (which must be consistent, or both 0-by-0) and rebuilds their schedules
 	*/
-	Matrix inv_mod(Matrix A) {
-
-		//Matrix inv = A;
-		int placeHolder = 0;
-
-		// First step is to create an identity matrix
-		Matrix inv = identityMatrix(A.size(1));
-
-		// Now we continue to do the same operation on both the original and the inverse matrix
-		// to obtain the answer.
-
-		// Traversing column wise
-		for (int j = 0; j < A.size(2); j++) {
-			
-			if (A.get(j, j) > 1)
-			{
-				int currentElement = A.get(j, j);
-				// Using row mult and doing same operations on both inverse and original matrix
-				row_mult(inv, j, 0, inv.size(2), ZI29[currentElement - 1]);
-				row_mult(A, j, 0, A.size(2), ZI29[currentElement - 1]);
-
-			}
-			
-			// Traversing row wise
-			for (int k = 0; k < A.size(1); k++) {
-				// If element isn't diagonal
-				if ((j != k) && (A.get(k, j) != 0)) {
-					placeHolder = A.get(k, j);
-					// Using row diff to make the other element 0, and then performing the same operation on inverse matrix
-					row_diff(inv, k, 0, inv.size(2), inv, j, placeHolder);
-					row_diff(A, k, 0, A.size(2), A, j, placeHolder);
-				}
-			}
-		}
+	void setKeys(const Matrix& E, const Matrix& D);
 
-		// Finally, the inverse matrix will contain the inverse matrix, while A will become identity matrix
-		if (A.equal(identityMatrix(A.size(2))))
-		{
-			for (int i = 0; i < (inv.size(1) * inv.size(2)); i++)
-			{
-				inv.set(i, mod(inv.get(i), 29));
-			}
-			return inv;
-		}
+	/*
+	* Lays out key K for translate(); a non-square K gives a schedule with n = 0, which translates nothing
+	*/
+	static Schedule schedule(const Matrix& K);
+
+	/*
+	* Writes square key K (n-by-n) row by row, reduced mod 29, to the n * n bytes at out
+	*/
+	static void reduceRows(const Matrix& K, unsigned char* out);
+
+	/*
+	* Translates (encrypts or decrypts) T with the key in schedule S, using up to the given number of threads (0 for one per core)
+	* returns an empty string if S has no key, T doesn't fill whole blocks or T has a character outside the alphabet
+	*/
+	std::string cipher(const Schedule& S, const std::string& T, unsigned int threads) const;
+
+	/*
+	* Translates length characters of T with the key in schedule S into out, which has room for capacity characters
+	* returns the number of characters written, 0 if S has no key, T isn't whole blocks or has a bad character, or out is too small
+	*/
+	static std::size_t cipher(const Schedule& S, const char* T, std::size_t length, char* out, std::size_t capacity);
+
+	/*
+	* Translates count texts with the key in schedule S into arena (see encryptBatch), all blocks of all texts in one pass
+	* returns the number of texts that were translated
+	*/
+	static std::size_t batch(const Schedule& S, const std::string* T, std::size_t count, std::string& arena, std::vector<std::size_t>& offsets);
+
+	/*
+	* Makes the best of the candidate decryption keys from a ciphertext-only attack this object's key
+	* returns false, leaving the keys alone, if there are none
+	*/
+	bool coaAdopt(const std::vector<Matrix>& best);
+
+	/*
+	* Ciphertext-only attack behind coa() and coaCandidates(): checks C, takes the sample and hands it to coaPairs or coaRows
+	* candidate plaintexts are judged with model, or the built-in English letter pairs if model is null
+	*/
+	std::vector<Matrix> coaSearch(const std::string& C, unsigned int n, unsigned int k, const NGramModel* model, unsigned int threads) const;
 
-		return Matrix(std::vector<int>(), 0, 0);
-	}
+	/*
+	* Ciphertext-only attack on a 2-by-2 key: scores every invertible decryption key on the (numerical) ciphertext c
+	* returns the k best, best first
+	*/
+	static std::vector<Matrix> coaPairs(const std::vector<unsigned char>& c, unsigned int k, const NGramModel* model, unsigned int threads);
+
+	/*
+	* Ciphertext-only attack on a 3-by-3 up to COA_MAX-by-COA_MAX key, one row at a time (see Hill.cpp)
+	* returns the k best decryption keys, best first
+	*/
+	static std::vector<Matrix> coaRows(const std::vector<unsigned char>& c, unsigned int n, unsigned int k, const NGramModel* model, unsigned int threads);
+
+	/*
+	* Translates length characters (whole blocks) of in with the key in schedule S and writes them to out (which may be in)
+	* each block is read, mapped to numbers, multiplied by the key, reduced mod 29 and written back as characters in one go
+	* returns false if a character is outside the alphabet (out is then only partly written)
+	*/
+	static bool translate(const Schedule& S, const char* in, std::size_t length, char* out);
+
+	/*
+	* Calculates the determinant of a square matrix mod 29 by fraction-free elimination
+	* returns a value in [0, 29), or -1 if A isn't square
+	*/
+	int det_mod(const Matrix& A) const;
+
+	/*
+	* Returns the greatest common divisor of a and b
+	*/
+	static unsigned int gcd(unsigned int a, unsigned int b);
+
+	/*
+	* Returns true if K is a square matrix that can be inverted mod 29, i.e. its determinant shares no factor with 29
+	*/
+	bool invertible(const Matrix& K) const;
+
+	/*
+	* Calculates the inverse of a matrix over Z_{29} by Gauss-Jordan elimination with row swaps
+	* returns a 0-by-0 matrix if A isn't square or isn't invertible mod 29
+	*/
+	Matrix inv_mod(const Matrix& A) const;
+
+	/*
+	* Returns the inverse of key K mod 29, a 0-by-0 matrix if K isn't invertible
+	* inverses of keys seen before come out of the process-wide cache; new ones are checked, inverted and added to it
+	*/
+	Matrix inverse(const Matrix& K) const;
 
   /* Calculates the remainder of the operation and returns it
   * c = a mod b, where c = [0,b)
@@ -245,7 +398,7 @@ private:
 
 		// We must account for the negative numbers
 		if (a < 0) {
-			return (b + (a % b));
+			return (b + (a % b)) % b;
 		}
 		// otherwise, just return the modulus
 		else {
@@ -253,29 +406,6 @@ private:
 		}
   }
 
-  //For row i of Matrix A, multiply columns j through k by c, mod 29
-  //(i.e., in Matlab notation A(i,j:k) = mod(c*A(i,j:k), 29))
-  //NOTE: matrix pass by reference means all operations occur in place
-  void row_mult(Matrix& A, unsigned int i, unsigned int j, unsigned int k, unsigned int c) {
-
-	  // using variable 'recursion' to avoid confusion between passed parameters and looping variable
-	  for (int recursion = j; recursion < k; recursion++) {
-		  // Logic is used from the given MATLAB notation, and set function from Matrix.cpp is used to set the value
-		  A.set(i, recursion, this->mod((c * A.get(i, recursion)), 29));
-	  }
-  }
-  //Multiply columns j through k of row l of Matrix B by c and subtract from columns j through k of row i of Matrix A, mod 29
-  //(i.e., in Matlab notation A(i,j:k) = mod(A(i,j:K) - c*B(l,j:k), 29)
-  //NOTE: matrix pass by reference means all operations occur in place
-  void row_diff(Matrix& A, unsigned int i, unsigned int j, unsigned int k, Matrix& B, unsigned int l, unsigned int c) {
-
-	  // using variable 'recursion' to avoid confusion between passed parameters and looping variable
-	  for (int recursion = j; recursion < k; recursion++) {
-		  // Logic is used from the given MATLAB notation, and set function from Matrix.cpp is used to set the value
-		  A.set(i, recursion, this->mod((A.get(i, recursion) - (c*B.get(l,recursion))), 29));
-	  }
-  }
-
   /*
   * Function that creates Identity Matrix of size (size x size)
   */
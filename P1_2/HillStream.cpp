@@ -0,0 +1,139 @@
+#include "HillStream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * Parameterized constructor.  Translated text is written to the given ostream.
+ * @param H - the Hill object whose keys to use.
+ * @param encryption - true to encrypt with H's encryption key, false to decrypt with its decryption key.
+ * @param out - where the translated text goes.
+ */
+HillStream::HillStream(const Hill& H, bool encryption, std::ostream& out)
+	: H(H), encryption(encryption), used(0), n(0), failed(false) {
+	std::ostream* target = &out;
+	this->sink = [target](const char* s, std::size_t length) { target->write(s, length); };
+	init();
+}
+
+/**
+ * Parameterized constructor.  Translated text is passed to the given callback, one buffer at a time.
+ * @param H - the Hill object whose keys to use.
+ * @param encryption - true to encrypt with H's encryption key, false to decrypt with its decryption key.
+ * @param sink - called with a pointer to and the length of each piece of translated text.
+ */
+HillStream::HillStream(const Hill& H, bool encryption, const std::function<void(const char*, std::size_t)>& sink)
+	: H(H), encryption(encryption), sink(sink), used(0), n(0), failed(false) {
+	init();
+}
+
+/*
+* Sets up the buffer for the key in H
+*/
+void HillStream::init() {
+	Matrix K = encryption ? H.getE() : H.getD();
+
+	// without a usable key nothing can be translated
+	if (K.size(1) == 0 || K.size(1) != K.size(2)) {
+		failed = true;
+		return;
+	}
+
+	// the buffer always holds whole blocks
+	n = K.size(1);
+	std::size_t capacity = CHUNK / n * n;
+	if (capacity == 0) {
+		capacity = n;
+	}
+	buffer.resize(capacity);
+}
+
+/**
+ * Feeds the next piece of text.
+ * @param s - the characters to translate.
+ * @param length - number of characters in s.
+ * @return true if everything so far could be translated, false once the key or any character was invalid.
+ */
+bool HillStream::write(const char* s, std::size_t length) {
+	while (!failed && length > 0) {
+		// copy as much as fits in the buffer
+		std::size_t count = std::min(length, buffer.size() - used);
+		std::memcpy(&buffer[used], s, count);
+		used += count;
+		s += count;
+		length -= count;
+
+		// a full buffer is always whole blocks
+		if (used == buffer.size()) {
+			flush(used);
+		}
+	}
+	return !failed;
+}
+
+/**
+ * Feeds the next piece of text.
+ * @param s - the characters to translate.
+ * @return true if everything so far could be translated, false once the key or any character was invalid.
+ */
+bool HillStream::write(const std::string& s) {
+	return write(s.data(), s.length());
+}
+
+/**
+ * Feeds everything left in the given istream and then finishes.
+ * @param in - where the text comes from.
+ * @return the result of finish().
+ */
+bool HillStream::run(std::istream& in) {
+	// read straight into the free part of the buffer
+	while (!failed && in) {
+		in.read(&buffer[used], buffer.size() - used);
+		used += static_cast<std::size_t>(in.gcount());
+		if (used == buffer.size()) {
+			flush(used);
+		}
+	}
+	return finish();
+}
+
+/**
+ * Translates and outputs whatever is still buffered; call once the whole text has been written.
+ * @return true if the whole text was translated, false if anything was invalid or the text didn't end on a whole block.
+ */
+bool HillStream::finish() {
+	if (failed) {
+		return false;
+	}
+
+	// only whole blocks can be translated, anything left over means the text was the wrong length
+	flush(used / n * n);
+	if (used != 0) {
+		failed = true;
+	}
+	return !failed;
+}
+
+/*
+* Translates the first length (a multiple of n) characters of the buffer and hands them to sink
+*/
+void HillStream::flush(std::size_t length) {
+	if (failed || length == 0) {
+		return;
+	}
+
+	// translated in place, so no memory is needed beyond the buffer
+	char* text = buffer.data();
+	std::size_t written = encryption ? H.encrypt(text, length, text, length) : H.decrypt(text, length, text, length);
+
+	// nothing written means something in this piece wasn't in the alphabet
+	if (written != length) {
+		failed = true;
+		return;
+	}
+	sink(text, length);
+
+	// move the partial block (if any) to the front
+	used -= length;
+	std::memmove(buffer.data(), buffer.data() + length, used);
+}
@@ -0,0 +1,82 @@
+#ifndef _HILLSTREAM_HPP_
+#define _HILLSTREAM_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Hill.hpp"
+
+/**
+ * A C++ class to encrypt/decrypt arbitrarily long text with the Hill cipher in constant memory.
+ * Text is fed in pieces of any size; whole blocks are collected in a fixed-size buffer, translated a buffer at a time and handed to the output as they are done.
+ * Characters that don't fill a whole block yet are carried over to the next piece.
+ */
+class HillStream
+{
+public:
+	/**
+	 * Parameterized constructor.  Translated text is written to the given ostream.
+	 * @param H - the Hill object whose keys to use.
+	 * @param encryption - true to encrypt with H's encryption key, false to decrypt with its decryption key.
+	 * @param out - where the translated text goes.
+	 */
+	HillStream(const Hill& H, bool encryption, std::ostream& out);
+
+	/**
+	 * Parameterized constructor.  Translated text is passed to the given callback, one buffer at a time.
+	 * @param H - the Hill object whose keys to use.
+	 * @param encryption - true to encrypt with H's encryption key, false to decrypt with its decryption key.
+	 * @param sink - called with a pointer to and the length of each piece of translated text.
+	 */
+	HillStream(const Hill& H, bool encryption, const std::function<void(const char*, std::size_t)>& sink);
+
+	/**
+	 * Feeds the next piece of text.
+	 * @param s - the characters to translate.
+	 * @param length - number of characters in s.
+	 * @return true if everything so far could be translated, false once the key or any character was invalid.
+	 */
+	bool write(const char* s, std::size_t length);
+
+	/**
+	 * Feeds the next piece of text.
+	 * @param s - the characters to translate.
+	 * @return true if everything so far could be translated, false once the key or any character was invalid.
+	 */
+	bool write(const std::string& s);
+
+	/**
+	 * Feeds everything left in the given istream and then finishes.
+	 * @param in - where the text comes from.
+	 * @return the result of finish().
+	 */
+	bool run(std::istream& in);
+
+	/**
+	 * Translates and outputs whatever is still buffered; call once the whole text has been written.
+	 * @return true if the whole text was translated, false if anything was invalid or the text didn't end on a whole block.
+	 */
+	bool finish();
+
+private:
+	Hill H; //keys to use (copies of the keys share their elements, so this is cheap)
+	bool encryption; //true to encrypt, false to decrypt
+	std::function<void(const char*, std::size_t)> sink; //where translated text goes
+	std::vector<char> buffer; //fixed-size buffer collecting text until it is translated
+	std::size_t used; //number of characters currently in buffer
+	unsigned int n; //block size, i.e. size of the key
+	bool failed; //set once anything couldn't be translated
+
+	//number of characters translated at a time (rounded down to whole blocks)
+	static const std::size_t CHUNK = 1 << 16;
+
+	//Sets up the buffer for the key in H
+	void init();
+
+	//Translates the first length (a multiple of n) characters of the buffer and hands them to sink
+	void flush(std::size_t length);
+};
+#endif
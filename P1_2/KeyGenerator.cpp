@@ -0,0 +1,193 @@
+#include "KeyGenerator.hpp"
+#include "Alphabet.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using alpha29::INV29;
+
+namespace {
+	/*
+	* splitmix64 finaliser: scrambles x so that neighbouring inputs give unrelated outputs
+	*/
+	std::uint64_t mix(std::uint64_t x) {
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	/*
+	* Random numbers for one key: word w is mix(base + w), so any key of the sequence can be drawn without drawing the ones before it
+	*/
+	struct Stream {
+		std::uint64_t base;
+		std::uint64_t word;
+		std::uint64_t bits;
+		unsigned int left; //32 bit halves of bits not used yet
+
+		Stream(std::uint64_t seed, std::uint64_t index) : base(mix(seed + mix(index))), word(0), bits(0), left(0) {}
+
+		/*
+		* Returns a random number in [0, m), scaled from 32 random bits (the bias is below 2^-27 for m <= 29)
+		*/
+		unsigned int below(unsigned int m) {
+			if (left == 0) {
+				bits = mix(base + word++);
+				left = 2;
+			}
+			std::uint64_t x = bits & 0xFFFFFFFFULL;
+			bits >>= 32;
+			left--;
+			return static_cast<unsigned int>((x * m) >> 32);
+		}
+	};
+}
+
+/**
+ * Parameterized constructor.  Starts a sequence of keys; the same seed always gives the same keys.
+ * @param seed - where the sequence starts.
+ */
+KeyGenerator::KeyGenerator(std::uint64_t seed) : seed(seed), counter(0) {
+}
+
+/**
+ * Draws the next key pair.
+ * @param n - size of the key, 2 up to MAX_KEY.
+ * @param E - receives the encryption key, reduced mod 29.
+ * @param D - receives the matching decryption key, reduced mod 29.
+ * @return true if a key was drawn, false if n is out of range (E/D are then left alone).
+ */
+bool KeyGenerator::next(unsigned int n, Matrix& E, Matrix& D) {
+	if (n < 2 || n > MAX_KEY) {
+		return false;
+	}
+	draw(seed, counter++, n, E, D);
+	return true;
+}
+
+/**
+ * Draws count key pairs in one go; they are the same keys count calls to next() would have given.
+ * @param n - size of the keys, 2 up to MAX_KEY.
+ * @param count - number of keys to draw.
+ * @param E - receives the encryption keys (resized to count).
+ * @param D - receives the matching decryption keys (resized to count).
+ * @param threads - number of threads to use, 0 for one per core
+ * @return the number of keys drawn: count, or 0 if n is out of range.
+ */
+std::size_t KeyGenerator::fill(unsigned int n, std::size_t count, std::vector<Matrix>& E, std::vector<Matrix>& D, unsigned int threads) {
+	if (n < 2 || n > MAX_KEY) {
+		return 0;
+	}
+	E.resize(count);
+	D.resize(count);
+
+	// a key costs about 2 n^3 multiply-adds; only spread the batch out when there's enough of it
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threads = static_cast<unsigned int>(std::min<std::size_t>(threads, count * n * n * n / (1 << 16) + 1));
+
+	// every key only depends on its number, so threads can take keys in any order and the batch comes out the same
+	std::uint64_t first = counter;
+	std::atomic<std::size_t> next(0);
+	auto work = [&]() {
+		for (std::size_t i = next++; i < count; i = next++) {
+			draw(seed, first + i, n, E[i], D[i]);
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < threads; t++) {
+		pool.push_back(std::thread(work));
+	}
+	work();
+	for (std::size_t t = 0; t < pool.size(); t++) {
+		pool[t].join();
+	}
+
+	counter += count;
+	return count;
+}
+
+/*
+* Draws key number index of the sequence started by seed
+* Randall's algorithm, grown one size at a time: a uniform invertible k-by-k E is B * T, where T is the identity with row r replaced
+* by a uniform non-zero v (r its first non-zero entry), and B has row 0 = e_r, a uniform column r below that and a uniform invertible
+* (k-1)-by-(k-1) S everywhere else.  Every E comes from exactly one (v, column, S), and B^-1 and T^-1 follow from S^-1 directly.
+*/
+void KeyGenerator::draw(std::uint64_t seed, std::uint64_t index, unsigned int n, Matrix& E, Matrix& D) {
+	Stream random(seed, index);
+
+	// S and S^-1 of the size before, and the new E and D, row by row with stride n; entries stay below 29, so a sum of at most 64
+	// products of two of them fits easily in 32 bits and is reduced only once
+	std::vector<unsigned int> S(n * n, 0), Si(n * n, 0), e(n * n, 0), d(n * n, 0);
+	std::vector<unsigned int> v(n), c(n);
+	for (unsigned int k = 1; k <= n; k++) {
+		unsigned int r;
+		do {
+			for (unsigned int j = 0; j < k; j++) {
+				v[j] = random.below(29);
+			}
+			r = 0;
+			while (r < k && v[r] == 0) {
+				r++;
+			}
+		} while (r == k);
+		for (unsigned int i = 1; i < k; i++) {
+			c[i] = random.below(29);
+		}
+
+		// B, and E = B * T: column r of B scaled by v[r], and column r of B times v[j] added to every other column j
+		// (row 0 of B is e_r, rows 1 on hold c in column r and S in the other columns)
+		for (unsigned int i = 0; i < k; i++) {
+			unsigned int br = i == 0 ? 1 : c[i];
+			for (unsigned int j = 0; j < k; j++) {
+				unsigned int b = i == 0 || j == r ? 0 : S[(i - 1) * n + (j < r ? j : j - 1)];
+				e[i * n + j] = j == r ? br * v[r] % 29 : (b + br * v[j]) % 29;
+			}
+		}
+
+		// B^-1: x = B^-1 y has x_r = y_0, and the other x are S^-1 (y_1.. - c y_0)
+		for (unsigned int j = 0; j < k; j++) {
+			if (j == r) {
+				d[j * n] = 1;
+				std::fill(d.begin() + j * n + 1, d.begin() + j * n + k, 0);
+				continue;
+			}
+			const unsigned int* s = &Si[(j < r ? j : j - 1) * n];
+			unsigned int sum = 0;
+			for (unsigned int t = 1; t < k; t++) {
+				sum += s[t - 1] * c[t];
+				d[j * n + t] = s[t - 1];
+			}
+			d[j * n] = (29 - sum % 29) % 29;
+		}
+		// D = T^-1 * B^-1: T^-1 is the identity but for row r, (e_r - v + e_r v[r]) / v[r], so only row r of B^-1 changes
+		for (unsigned int t = 0; t < k; t++) {
+			unsigned int sum = d[r * n + t];
+			for (unsigned int j = 0; j < k; j++) {
+				if (j != r) {
+					sum += (29 - v[j]) * d[j * n + t];
+				}
+			}
+			d[r * n + t] = sum % 29 * INV29[v[r]] % 29;
+		}
+		S.swap(e);
+		Si.swap(d);
+	}
+
+	std::vector<int> values(n * n);
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			values[j * n + i] = static_cast<int>(S[i * n + j]);
+		}
+	}
+	E = Matrix(values, n, n);
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			values[j * n + i] = static_cast<int>(Si[i * n + j]);
+		}
+	}
+	D = Matrix(values, n, n);
+}
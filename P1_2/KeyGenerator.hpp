@@ -0,0 +1,57 @@
+#ifndef _KEYGENERATOR_HPP_
+#define _KEYGENERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Matrix.hpp"
+
+/**
+ * A C++ class to draw random Hill cipher keys over our 29 character alphabet, each as an encryption key E together with its decryption key D.
+ * E is uniform over all invertible n-by-n matrices mod 29 (Randall's algorithm): it is built up one size at a time from random factors
+ * whose inverses are known, so it is invertible by construction and D comes out alongside it without a general inversion.
+ * Key number i only depends on the seed and i (a counter-based generator), so a batch gives the same keys however many threads fill it.
+ */
+class KeyGenerator
+{
+public:
+	//largest key (MAX_KEY-by-MAX_KEY) that can be drawn
+	static const unsigned int MAX_KEY = 64;
+
+	/**
+	 * Parameterized constructor.  Starts a sequence of keys; the same seed always gives the same keys.
+	 * @param seed - where the sequence starts.
+	 */
+	explicit KeyGenerator(std::uint64_t seed);
+
+	/**
+	 * Draws the next key pair.
+	 * @param n - size of the key, 2 up to MAX_KEY.
+	 * @param E - receives the encryption key, reduced mod 29.
+	 * @param D - receives the matching decryption key, reduced mod 29.
+	 * @return true if a key was drawn, false if n is out of range (E/D are then left alone).
+	 */
+	bool next(unsigned int n, Matrix& E, Matrix& D);
+
+	/**
+	 * Draws count key pairs in one go; they are the same keys count calls to next() would have given.
+	 * @param n - size of the keys, 2 up to MAX_KEY.
+	 * @param count - number of keys to draw.
+	 * @param E - receives the encryption keys (resized to count).
+	 * @param D - receives the matching decryption keys (resized to count).
+	 * @param threads - number of threads to use, 0 for one per core
+	 * @return the number of keys drawn: count, or 0 if n is out of range.
+	 */
+	std::size_t fill(unsigned int n, std::size_t count, std::vector<Matrix>& E, std::vector<Matrix>& D, unsigned int threads = 0);
+
+private:
+	std::uint64_t seed; //where the sequence started
+	std::uint64_t counter; //number of keys drawn so far
+
+	/*
+	* Draws key number index of the sequence started by seed
+	*/
+	static void draw(std::uint64_t seed, std::uint64_t index, unsigned int n, Matrix& E, Matrix& D);
+};
+#endif
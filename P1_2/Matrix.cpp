@@ -1,11 +1,417 @@
 // Header Files
 #include "Matrix.hpp"
-#include <iostream>;
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 
 using std::cout;
 
 using namespace std;
 
+namespace {
+    // a * b, or false if it doesn't fit in 64 bits
+    bool multiply(long long a, long long b, long long& out) {
+        // each sign combination has its own bound (the usual checks from the CERT C rules)
+        if (a > 0) {
+            if ((b > 0 && a > LLONG_MAX / b) || (b <= 0 && b < LLONG_MIN / a)) {
+                return false;
+            }
+        }
+        else if ((b > 0 && a < LLONG_MIN / b) || (b <= 0 && a != 0 && b < LLONG_MAX / a)) {
+            return false;
+        }
+        out = a * b;
+        return true;
+    }
+
+    // a - b, or false if it doesn't fit in 64 bits
+    bool subtract(long long a, long long b, long long& out) {
+        if ((b < 0 && a > LLONG_MAX + b) || (b > 0 && a < LLONG_MIN + b)) {
+            return false;
+        }
+        out = a - b;
+        return true;
+    }
+
+    // a + b, or false if it doesn't fit in 64 bits
+    bool addTo(long long a, long long b, long long& out) {
+        if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b)) {
+            return false;
+        }
+        out = a + b;
+        return true;
+    }
+
+    // (a * b - c * d) / p, where the division is known to be exact, or false if the result doesn't fit in 64 bits
+    bool cross(long long a, long long b, long long c, long long d, long long p, long long& out) {
+#if defined(__SIZEOF_INT128__)
+        // the products may not fit in 64 bits even when the quotient does
+        __int128 r = (static_cast<__int128>(a) * b - static_cast<__int128>(c) * d) / p;
+        if (r > LLONG_MAX || r < LLONG_MIN) {
+            return false;
+        }
+        out = static_cast<long long>(r);
+        return true;
+#else
+        long long ab, cd, difference;
+        if (!multiply(a, b, ab) || !multiply(c, d, cd) || !subtract(ab, cd, difference)) {
+            return false;
+        }
+        out = difference / p;
+        return true;
+#endif
+    }
+
+    // multiplicative inverse of a mod p (a in [1, p)), by the extended Euclidean algorithm
+    unsigned int inverseMod(unsigned int a, unsigned int p) {
+        long long r0 = p, r1 = a, t0 = 0, t1 = 1;
+        while (r1 != 0) {
+            long long q = r0 / r1;
+            long long r = r0 - q * r1;
+            r0 = r1;
+            r1 = r;
+            long long t = t0 - q * t1;
+            t0 = t1;
+            t1 = t;
+        }
+        return static_cast<unsigned int>((t0 % p + p) % p);
+    }
+
+    // row[k] += g[0] * pivot[0][k] + ... + g[3] * pivot[3][k] for k in [from, to): the inner loop of modular elimination, four pivot rows
+    // at a time so each element of row is loaded and stored once for all four
+    typedef void (*AddMultiples)(unsigned int* row, const unsigned int* const* pivot, const unsigned int* g, unsigned int from, unsigned int to);
+
+    void addMultiples(unsigned int* row, const unsigned int* const* pivot, const unsigned int* g, unsigned int from, unsigned int to) {
+        const unsigned int* p0 = pivot[0];
+        const unsigned int* p1 = pivot[1];
+        const unsigned int* p2 = pivot[2];
+        const unsigned int* p3 = pivot[3];
+        unsigned int g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3];
+        for (unsigned int k = from; k < to; k++) {
+            row[k] += g0 * p0[k] + g1 * p1[k] + g2 * p2[k] + g3 * p3[k];
+        }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    // the same loop compiled for AVX2, whose 8-lane 32 bit multiply is about three times as fast as what SSE2 can do
+    __attribute__((target("avx2"))) void addMultiplesAvx2(unsigned int* row, const unsigned int* const* pivot, const unsigned int* g, unsigned int from, unsigned int to) {
+        const unsigned int* p0 = pivot[0];
+        const unsigned int* p1 = pivot[1];
+        const unsigned int* p2 = pivot[2];
+        const unsigned int* p3 = pivot[3];
+        unsigned int g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3];
+        for (unsigned int k = from; k < to; k++) {
+            row[k] += g0 * p0[k] + g1 * p1[k] + g2 * p2[k] + g3 * p3[k];
+        }
+    }
+#endif
+
+    // the fastest version of addMultiples this processor can run, picked the first time it is needed
+    AddMultiples addMultiplesFast() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        static const AddMultiples chosen = (__builtin_cpu_init(), __builtin_cpu_supports("avx2")) ? addMultiplesAvx2 : addMultiples;
+        return chosen;
+#else
+        return addMultiples;
+#endif
+    }
+
+    // rows[i][k] += g[i * stride + q] . (panel rows 2q and 2q + 1 at column k) for i in [0, count), q in [0, pairs), k in [from, to):
+    // the trailing update of a panel of pivots as a matrix product.  Every value is below 2^15, so each multiplier holds two 16 bit
+    // factors (low half for row 2q) and the panel keeps rows 2q and 2q + 1 interleaved, 2 * width values per pair
+    typedef void (*AddProducts)(unsigned int* const* rows, unsigned int count, const unsigned int* g, std::size_t stride,
+                                const unsigned short* panel, unsigned int pairs, unsigned int width, unsigned int from, unsigned int to);
+
+    void addProducts(unsigned int* const* rows, unsigned int count, const unsigned int* g, std::size_t stride,
+                     const unsigned short* panel, unsigned int pairs, unsigned int width, unsigned int from, unsigned int to) {
+        for (unsigned int i = 0; i < count; i++) {
+            unsigned int* row = rows[i];
+            const unsigned int* gi = g + i * stride;
+            // four pairs at a time, so each element of row is loaded and stored once for all eight terms
+            unsigned int q = 0;
+            for (; q + 4 <= pairs; q += 4) {
+                unsigned int a0 = gi[q] & 0xFFFF, a1 = gi[q] >> 16, b0 = gi[q + 1] & 0xFFFF, b1 = gi[q + 1] >> 16;
+                unsigned int c0 = gi[q + 2] & 0xFFFF, c1 = gi[q + 2] >> 16, d0 = gi[q + 3] & 0xFFFF, d1 = gi[q + 3] >> 16;
+                const unsigned short* pa = panel + static_cast<std::size_t>(q) * 2 * width;
+                const unsigned short* pb = pa + 2 * static_cast<std::size_t>(width);
+                const unsigned short* pc = pb + 2 * static_cast<std::size_t>(width);
+                const unsigned short* pd = pc + 2 * static_cast<std::size_t>(width);
+                for (unsigned int k = from; k < to; k++) {
+                    row[k] += a0 * pa[2 * k] + a1 * pa[2 * k + 1] + b0 * pb[2 * k] + b1 * pb[2 * k + 1]
+                            + c0 * pc[2 * k] + c1 * pc[2 * k + 1] + d0 * pd[2 * k] + d1 * pd[2 * k + 1];
+                }
+            }
+            for (; q < pairs; q++) {
+                unsigned int a0 = gi[q] & 0xFFFF, a1 = gi[q] >> 16;
+                const unsigned short* pa = panel + static_cast<std::size_t>(q) * 2 * width;
+                for (unsigned int k = from; k < to; k++) {
+                    row[k] += a0 * pa[2 * k] + a1 * pa[2 * k + 1];
+                }
+            }
+        }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    // the same with SSE2 (every x86-64 processor has it) on tiles of 4 rows by 8 columns, which stay in registers over all the pairs:
+    // pmaddwd multiplies both halves of a pair and adds them in one instruction, and the panel (pairs * width * 4 bytes) stays in cache
+    // for every tile
+    __attribute__((target("sse2"))) void addProductsSse2(unsigned int* const* rows, unsigned int count, const unsigned int* g, std::size_t stride,
+                                                         const unsigned short* panel, unsigned int pairs, unsigned int width, unsigned int from, unsigned int to) {
+        unsigned int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const unsigned int* g0 = g + i * stride;
+            const unsigned int* g1 = g0 + stride;
+            const unsigned int* g2 = g1 + stride;
+            const unsigned int* g3 = g2 + stride;
+            unsigned int k = from;
+            for (; k + 8 <= to; k += 8) {
+                __m128i c00 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i] + k));
+                __m128i c01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i] + k + 4));
+                __m128i c10 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i + 1] + k));
+                __m128i c11 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i + 1] + k + 4));
+                __m128i c20 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i + 2] + k));
+                __m128i c21 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i + 2] + k + 4));
+                __m128i c30 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i + 3] + k));
+                __m128i c31 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[i + 3] + k + 4));
+                const unsigned short* pk = panel + 2 * static_cast<std::size_t>(k);
+                for (unsigned int q = 0; q < pairs; q++, pk += 2 * static_cast<std::size_t>(width)) {
+                    // both halves of the 32 bit lanes are below 2^15, so the signed 16 bit products are the right ones
+                    __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pk));
+                    __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pk + 8));
+                    __m128i a = _mm_set1_epi32(static_cast<int>(g0[q]));
+                    c00 = _mm_add_epi32(c00, _mm_madd_epi16(a, b0));
+                    c01 = _mm_add_epi32(c01, _mm_madd_epi16(a, b1));
+                    a = _mm_set1_epi32(static_cast<int>(g1[q]));
+                    c10 = _mm_add_epi32(c10, _mm_madd_epi16(a, b0));
+                    c11 = _mm_add_epi32(c11, _mm_madd_epi16(a, b1));
+                    a = _mm_set1_epi32(static_cast<int>(g2[q]));
+                    c20 = _mm_add_epi32(c20, _mm_madd_epi16(a, b0));
+                    c21 = _mm_add_epi32(c21, _mm_madd_epi16(a, b1));
+                    a = _mm_set1_epi32(static_cast<int>(g3[q]));
+                    c30 = _mm_add_epi32(c30, _mm_madd_epi16(a, b0));
+                    c31 = _mm_add_epi32(c31, _mm_madd_epi16(a, b1));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i] + k), c00);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i] + k + 4), c01);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i + 1] + k), c10);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i + 1] + k + 4), c11);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i + 2] + k), c20);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i + 2] + k + 4), c21);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i + 3] + k), c30);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rows[i + 3] + k + 4), c31);
+            }
+            if (k < to) {
+                addProducts(rows + i, 4, g0, stride, panel, pairs, width, k, to);
+            }
+        }
+        if (i < count) {
+            addProducts(rows + i, count - i, g + i * stride, stride, panel, pairs, width, from, to);
+        }
+    }
+
+    // and with AVX2 on tiles of 4 rows by 16 columns, twice as wide
+    __attribute__((target("avx2"))) void addProductsAvx2(unsigned int* const* rows, unsigned int count, const unsigned int* g, std::size_t stride,
+                                                         const unsigned short* panel, unsigned int pairs, unsigned int width, unsigned int from, unsigned int to) {
+        unsigned int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const unsigned int* g0 = g + i * stride;
+            const unsigned int* g1 = g0 + stride;
+            const unsigned int* g2 = g1 + stride;
+            const unsigned int* g3 = g2 + stride;
+            unsigned int k = from;
+            for (; k + 16 <= to; k += 16) {
+                __m256i c00 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i] + k));
+                __m256i c01 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i] + k + 8));
+                __m256i c10 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i + 1] + k));
+                __m256i c11 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i + 1] + k + 8));
+                __m256i c20 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i + 2] + k));
+                __m256i c21 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i + 2] + k + 8));
+                __m256i c30 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i + 3] + k));
+                __m256i c31 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[i + 3] + k + 8));
+                const unsigned short* pk = panel + 2 * static_cast<std::size_t>(k);
+                for (unsigned int q = 0; q < pairs; q++, pk += 2 * static_cast<std::size_t>(width)) {
+                    __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pk));
+                    __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pk + 16));
+                    __m256i a = _mm256_set1_epi32(static_cast<int>(g0[q]));
+                    c00 = _mm256_add_epi32(c00, _mm256_madd_epi16(a, b0));
+                    c01 = _mm256_add_epi32(c01, _mm256_madd_epi16(a, b1));
+                    a = _mm256_set1_epi32(static_cast<int>(g1[q]));
+                    c10 = _mm256_add_epi32(c10, _mm256_madd_epi16(a, b0));
+                    c11 = _mm256_add_epi32(c11, _mm256_madd_epi16(a, b1));
+                    a = _mm256_set1_epi32(static_cast<int>(g2[q]));
+                    c20 = _mm256_add_epi32(c20, _mm256_madd_epi16(a, b0));
+                    c21 = _mm256_add_epi32(c21, _mm256_madd_epi16(a, b1));
+                    a = _mm256_set1_epi32(static_cast<int>(g3[q]));
+                    c30 = _mm256_add_epi32(c30, _mm256_madd_epi16(a, b0));
+                    c31 = _mm256_add_epi32(c31, _mm256_madd_epi16(a, b1));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i] + k), c00);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i] + k + 8), c01);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i + 1] + k), c10);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i + 1] + k + 8), c11);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i + 2] + k), c20);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i + 2] + k + 8), c21);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i + 3] + k), c30);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows[i + 3] + k + 8), c31);
+            }
+            if (k < to) {
+                addProducts(rows + i, 4, g0, stride, panel, pairs, width, k, to);
+            }
+        }
+        if (i < count) {
+            addProducts(rows + i, count - i, g + i * stride, stride, panel, pairs, width, from, to);
+        }
+    }
+
+#endif
+
+    // the fastest version of addProducts this processor can run, picked the first time it is needed
+    AddProducts addProductsFast() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        static const AddProducts chosen = (__builtin_cpu_init(), __builtin_cpu_supports("avx2")) ? addProductsAvx2
+                                        : __builtin_cpu_supports("sse2") ? addProductsSse2 : addProducts;
+        return chosen;
+#else
+        return addProducts;
+#endif
+    }
+
+    // a[k] %= p for k in [0, n), p in [2, 2^15): x / p is at most one below the high half of x * floor((2^32 - 1) / p), which unlike
+    // a division by a variable vectorises
+    void modulo(unsigned int* a, std::size_t n, unsigned int p) {
+        unsigned int scale = 0xFFFFFFFFu / p;
+        for (std::size_t k = 0; k < n; k++) {
+            unsigned int r = a[k] - static_cast<unsigned int>((static_cast<unsigned long long>(a[k]) * scale) >> 32) * p;
+            a[k] = r >= p ? r - p : r;
+        }
+    }
+
+    // smallest number of elements worth giving a thread of its own
+    const std::size_t PARALLEL_MIN = 1 << 18;
+
+    // rows and terms of a product worked on at a time: a MULT_ROWS-by-MULT_DEPTH block of ints is 128 KB, so it stays in cache
+    const unsigned int MULT_ROWS = 256;
+    const unsigned int MULT_DEPTH = 128;
+
+    // the reduction kernels below keep four independent accumulators, so consecutive additions don't wait on each other
+    // and the compiler can spread them over vector lanes
+
+    // a[0] + ... + a[n - 1]
+    long long sumOf(const int* a, std::size_t n) {
+        long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += a[i];
+            s1 += a[i + 1];
+            s2 += a[i + 2];
+            s3 += a[i + 3];
+        }
+        for (; i < n; i++) {
+            s0 += a[i];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // |a[0]| + ... + |a[n - 1]|
+    long long absSumOf(const int* a, std::size_t n) {
+        long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += std::llabs(a[i]);
+            s1 += std::llabs(a[i + 1]);
+            s2 += std::llabs(a[i + 2]);
+            s3 += std::llabs(a[i + 3]);
+        }
+        for (; i < n; i++) {
+            s0 += std::llabs(a[i]);
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // a[0] * b[0] + ... + a[n - 1] * b[n - 1]
+    long long dotOf(const int* a, const int* b, std::size_t n) {
+        long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += static_cast<long long>(a[i]) * b[i];
+            s1 += static_cast<long long>(a[i + 1]) * b[i + 1];
+            s2 += static_cast<long long>(a[i + 2]) * b[i + 2];
+            s3 += static_cast<long long>(a[i + 3]) * b[i + 3];
+        }
+        for (; i < n; i++) {
+            s0 += static_cast<long long>(a[i]) * b[i];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // a[0] * b[0] + ... + a[n - 1] * b[n - 1] in int arithmetic like mult, so it vectorises; wraps around instead of overflowing
+    int productOf(const int* a, const int* b, std::size_t n) {
+        unsigned int s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += static_cast<unsigned int>(a[i]) * static_cast<unsigned int>(b[i]);
+            s1 += static_cast<unsigned int>(a[i + 1]) * static_cast<unsigned int>(b[i + 1]);
+            s2 += static_cast<unsigned int>(a[i + 2]) * static_cast<unsigned int>(b[i + 2]);
+            s3 += static_cast<unsigned int>(a[i + 3]) * static_cast<unsigned int>(b[i + 3]);
+        }
+        for (; i < n; i++) {
+            s0 += static_cast<unsigned int>(a[i]) * static_cast<unsigned int>(b[i]);
+        }
+        return static_cast<int>((s0 + s1) + (s2 + s3));
+    }
+
+    // the smallest (less = true) or largest of a[0], ..., a[n - 1]; n must be at least 1
+    int extremeOf(const int* a, std::size_t n, bool less) {
+        int e0 = a[0], e1 = a[0], e2 = a[0], e3 = a[0];
+        std::size_t i = 0;
+        if (less) {
+            for (; i + 4 <= n; i += 4) {
+                e0 = std::min(e0, a[i]);
+                e1 = std::min(e1, a[i + 1]);
+                e2 = std::min(e2, a[i + 2]);
+                e3 = std::min(e3, a[i + 3]);
+            }
+            for (; i < n; i++) {
+                e0 = std::min(e0, a[i]);
+            }
+            return std::min(std::min(e0, e1), std::min(e2, e3));
+        }
+        for (; i + 4 <= n; i += 4) {
+            e0 = std::max(e0, a[i]);
+            e1 = std::max(e1, a[i + 1]);
+            e2 = std::max(e2, a[i + 2]);
+            e3 = std::max(e3, a[i + 3]);
+        }
+        for (; i < n; i++) {
+            e0 = std::max(e0, a[i]);
+        }
+        return std::max(std::max(e0, e1), std::max(e2, e3));
+    }
+
+    // where v first turns up in a[0], ..., a[n - 1] (n if it doesn't)
+    std::size_t find(const int* a, std::size_t n, int v) {
+        return static_cast<std::size_t>(std::find(a, a + n, v) - a);
+    }
+
+    // greatest common divisor of |a| and |b|
+    long long gcd(long long a, long long b) {
+        unsigned long long x = a < 0 ? 0ULL - static_cast<unsigned long long>(a) : static_cast<unsigned long long>(a);
+        unsigned long long y = b < 0 ? 0ULL - static_cast<unsigned long long>(b) : static_cast<unsigned long long>(b);
+        while (y != 0) {
+            unsigned long long t = x % y;
+            x = y;
+            y = t;
+        }
+        return static_cast<long long>(x);
+    }
+}
+
 /**
 * Outputs this Matrix object on the given ostream (for debugging).
 * @param out - the ostream object to use to output.
@@ -31,7 +437,7 @@ void Matrix::output(std::ostream& out) const
  */
 Matrix::Matrix() {
     // Sets all values to 0
-    A = { 0,0,0,0 };
+    A = std::make_shared<std::vector<int> >(4, 0);
     // m gives the number of rows, while n gives the number of columns
     m = 2, n = 2;
 }
@@ -47,14 +453,14 @@ Matrix::Matrix(const std::vector<int>& A, unsigned int n) {
     if ((n != 0) && (A.size() % n == 0)) {
         this->m = A.size() / n;
         this->n = n;
-        this->A = A;
+        this->A = std::make_shared<std::vector<int> >(A);
     }
 
     // if it is empty or inconsistent, then make a 0x0 matrix
     else {
         this->m = 0;
         this->n = 0;
-        this->A = {};
+        this->A = std::make_shared<std::vector<int> >();
     }
 }
 
@@ -72,14 +478,29 @@ Matrix::Matrix(const std::vector<int>& A, unsigned int m, unsigned int n) {
     if (A.size() == sizeOfArray) {
         this->m = m;
         this->n = n;
-        this->A = A;
+        this->A = std::make_shared<std::vector<int> >(A);
     }
 
     // otherwise make it a 0x0 matrix
     else {
         this->m = 0;
         this->n = 0;
-        this->A = {};
+        this->A = std::make_shared<std::vector<int> >();
+    }
+}
+
+/**
+ * Gives this object its own copy of the elements if they are shared with another Matrix; must be called before any write to A.
+ */
+void Matrix::detach() {
+    // only copy when some other Matrix is still looking at the same elements
+    if (A.use_count() > 1) {
+        A = std::make_shared<std::vector<int> >(*A);
+    }
+    // use_count() is a relaxed read; a count of 1 may come from another thread having just dropped its copy, so pair with the
+    // release in that drop before writing, or the write could overtake that thread's last reads of the elements
+    else {
+        std::atomic_thread_fence(std::memory_order_acquire);
     }
 }
 
@@ -93,12 +514,12 @@ int Matrix::get(unsigned int i) const {
     int minVal = -2147483648;
 
     // if given index is outside of A's range
-    if (i >= this->A.size()) {
+    if (i >= this->A->size()) {
         return minVal;  // return the smallest int value
     }
 
     else {
-        return A.at(i); // return the value at the specified index
+        return (*A)[i]; // return the value at the specified index
     }
 }
 
@@ -115,13 +536,21 @@ int Matrix::get(unsigned int i, unsigned int j) const {
     // if given indexes (i,j) are within the bounds of the size of the matrix (m,n)
     if (this->m > i && this->n > j) {
         int pos = (j * m) + i;
-        return this->A[pos]; // return the value at the position
+        return (*this->A)[pos]; // return the value at the position
     }
     else {
         return minVal; // otherwise return the smallest int value
     }
 }
 
+/**
+ * Returns a pointer to the elements, stored column-wise; valid until this object is modified or destroyed.
+ * @return pointer to the first of size(1) * size(2) elements.
+ */
+const int* Matrix::data() const {
+    return A->data();
+}
+
 /**
  * Sets the element at specified linear index i to given value; if index is invalid matrix should not be modified.
  * @param i - column-wise (linear) index of object to set.
@@ -133,7 +562,8 @@ bool Matrix::set(unsigned int i, int ai) {
 
     // if given index is within the size
     if (i < size) {
-        A[i] = ai;
+        detach();
+        (*A)[i] = ai;
         return true;
     }
     else
@@ -153,7 +583,8 @@ bool Matrix::set(unsigned int i, unsigned int j, int aij) {
 
     // if the index is within the constraints of the size
     if (i < m && j < n) {
-        A[arithmetic] = aij; // setting the value
+        detach();
+        (*A)[arithmetic] = aij; // setting the value
         return true;
     }
     else
@@ -192,10 +623,15 @@ bool Matrix::equal(const Matrix& rhs) const {
     // if the dimensions for rows and columns match for both the matrices
     if (m == rhs.m && n == rhs.n) {
 
+        // copies that still share their elements are trivially equal
+        if (A == rhs.A) {
+            return true;
+        }
+
         // get into a loop and traverse through the size for all elements
         for (int i = 0; i < (m * n); i++) {
             // if it matches
-            if (A[i] == rhs.A[i]) {
+            if ((*A)[i] == (*rhs.A)[i]) {
                 if (i + 1 == m * n) { // continuing the loop.
                     return true;
                 }
@@ -206,6 +642,9 @@ bool Matrix::equal(const Matrix& rhs) const {
                 return false;
             }
         }
+
+        // nothing to compare (e.g. two 0-by-0 matrices)
+        return true;
     }
 
     // if dimensions don't match, it's automatically a false
@@ -223,7 +662,7 @@ bool Matrix::equal(const Matrix& rhs) const {
 const Matrix Matrix::add(const Matrix& rhs) const {
 
     // creating placeholder vector and filling it up with 0 as a temporary
-    std::vector<int> placeHolder(A.size(), 0);
+    std::vector<int> placeHolder(A->size(), 0);
     Matrix result(placeHolder, m, n);
 
     // if size is inconsistent, make it a 0x0 matrix
@@ -251,7 +690,7 @@ const Matrix Matrix::add(const Matrix& rhs) const {
 const Matrix Matrix::sub(const Matrix& rhs) const {
 
     // placeholder empty vector that helps to store values
-    std::vector<int> placeHolder(A.size(), 0);
+    std::vector<int> placeHolder(A->size(), 0);
     Matrix result(placeHolder, m, n);
 
     // if size is inconsistent, make it a 0x0 matrix
@@ -277,31 +716,7 @@ const Matrix Matrix::sub(const Matrix& rhs) const {
  * @param rhs - the Matrix object to multiply with this object.
  */
 const Matrix Matrix::mult(const Matrix& rhs) const {
-    // for multiplication, the columns of first matrix should match the rows of the second matrix
-    // if it doesn't; return empty matrix
-    if (n != rhs.m) {
-        return Matrix({}, 0, 0);
-    }
-    else {
-        int size = this->m * rhs.n;
-        std::vector<int> placeHolder(size, 0);
-        Matrix result(placeHolder, m, n);
-        int temp = 0;
-        // otherwise if it does, then traverse thru the values
-
-        for (int i = 0; i < this->m; i++) {
-            for (int j = 0; j < rhs.n; j++) {
-                // traverse again to fill up the temp values
-                temp = 0;
-                for (int k = 0; k < this->n; k++) {
-                    temp = temp + this->get(i, k) * rhs.get(k, j);
-                }
-                // set this result using the temp val
-                result.set(i, j, temp);
-            }
-        }
-        return result;
-    }
+    return mult(rhs, false, false);
 }
 
 /**
@@ -327,6 +742,116 @@ const Matrix Matrix::mult(int c) const {
     return result;
 }
 
+/**
+ * Creates and returns a new Matrix object that is op(this) * op(rhs), where op transposes its matrix if the matching flag is set;
+ * the transposes are never built, the column-wise layout is read the way each product needs it.
+ * @return a new Matrix object with the product, a 0-by-0 matrix if the (transposed) matrices can't be multiplied.
+ * @param rhs - the Matrix object to multiply with this object.
+ * @param transThis - true to multiply with this^T instead of this.
+ * @param transRhs - true to multiply with rhs^T instead of rhs.
+ */
+const Matrix Matrix::mult(const Matrix& rhs, bool transThis, bool transRhs) const {
+    unsigned int rows = transThis ? n : m, inner = transThis ? m : n;
+    unsigned int cols = transRhs ? rhs.m : rhs.n;
+    if (inner != (transRhs ? rhs.n : rhs.m)) {
+        return Matrix({}, 0, 0);
+    }
+    Matrix result = zeros(rows, cols);
+    const int* a = A->data();
+    const int* b = rhs.A->data();
+    int* c = result.A->data();
+
+    // element (k, j) of op(rhs) is b[k * bk + j * bj]
+    std::size_t bk = transRhs ? rhs.m : 1, bj = transRhs ? 1 : rhs.m;
+
+    // threads take columns of the result; each one works through blocks of MULT_ROWS rows by MULT_DEPTH terms so the part of this it
+    // reads stays in cache for all of its columns.  Sums are taken in unsigned arithmetic, so they wrap around instead of overflowing
+    std::size_t work = static_cast<std::size_t>(rows) * cols * inner;
+    parallel(cols, pieces(work), [&](unsigned int, std::size_t begin, std::size_t end) {
+        // for this^T * rhs^T, the thread's columns of rhs^T over the current terms, packed once per block of terms
+        std::vector<int> packed(transThis && transRhs ? (end - begin) * MULT_DEPTH : 0);
+        for (unsigned int k0 = 0; k0 < inner; k0 += MULT_DEPTH) {
+            unsigned int k1 = std::min(inner, k0 + MULT_DEPTH);
+            if (!packed.empty()) {
+                for (std::size_t j = begin; j < end; j++) {
+                    const int* bjk = b + j * bj;
+                    int* pj = &packed[(j - begin) * MULT_DEPTH];
+                    for (unsigned int k = k0; k < k1; k++) {
+                        pj[k - k0] = bjk[k * bk];
+                    }
+                }
+            }
+            for (unsigned int i0 = 0; i0 < rows; i0 += MULT_ROWS) {
+                unsigned int i1 = std::min(rows, i0 + MULT_ROWS);
+                for (std::size_t j = begin; j < end; j++) {
+                    int* cj = c + j * rows;
+                    const int* bjk = b + j * bj;
+
+                    // this * op(rhs): column j of the result is the sum of the columns k of this (contiguous), each times op(rhs)(k, j)
+                    // (four columns at a time, so column j is loaded and stored a quarter as often)
+                    if (!transThis) {
+                        unsigned int k = k0;
+                        for (; k + 4 <= k1; k += 4) {
+                            unsigned int s0 = static_cast<unsigned int>(bjk[k * bk]), s1 = static_cast<unsigned int>(bjk[(k + 1) * bk]);
+                            unsigned int s2 = static_cast<unsigned int>(bjk[(k + 2) * bk]), s3 = static_cast<unsigned int>(bjk[(k + 3) * bk]);
+                            const int* a0 = a + static_cast<std::size_t>(k) * m;
+                            const int* a1 = a0 + m;
+                            const int* a2 = a1 + m;
+                            const int* a3 = a2 + m;
+                            for (unsigned int i = i0; i < i1; i++) {
+                                cj[i] = static_cast<int>(static_cast<unsigned int>(cj[i]) + s0 * static_cast<unsigned int>(a0[i]) + s1 * static_cast<unsigned int>(a1[i])
+                                                         + s2 * static_cast<unsigned int>(a2[i]) + s3 * static_cast<unsigned int>(a3[i]));
+                            }
+                        }
+                        for (; k < k1; k++) {
+                            unsigned int scale = static_cast<unsigned int>(bjk[k * bk]);
+                            const int* ak = a + static_cast<std::size_t>(k) * m;
+                            for (unsigned int i = i0; i < i1; i++) {
+                                cj[i] = static_cast<int>(static_cast<unsigned int>(cj[i]) + scale * static_cast<unsigned int>(ak[i]));
+                            }
+                        }
+                    }
+
+                    // this^T * op(rhs): element (i, j) is the dot product of column i of this (contiguous) with column j of op(rhs),
+                    // which is contiguous too without transRhs and was packed with it
+                    else {
+                        const int* column = transRhs ? &packed[(j - begin) * MULT_DEPTH] : bjk + k0;
+                        for (unsigned int i = i0; i < i1; i++) {
+                            unsigned int dot = static_cast<unsigned int>(productOf(a + static_cast<std::size_t>(i) * m + k0, column, k1 - k0));
+                            cj[i] = static_cast<int>(static_cast<unsigned int>(cj[i]) + dot);
+                        }
+                    }
+                }
+            }
+        }
+    });
+    return result;
+}
+
+/**
+ * Creates and returns the Gram matrix this^T * this, the dot products of every pair of columns; only half of it is computed,
+ * the other half is the same by symmetry.
+ * @return a new n-by-n Matrix object that is this^T * this.
+ */
+const Matrix Matrix::gram() const {
+    Matrix result = zeros(n, n);
+    const int* a = A->data();
+    int* out = result.A->data();
+
+    // column j needs j + 1 dot products, so threads deal the columns out round robin instead of taking a range each
+    unsigned int count = pieces(static_cast<std::size_t>(n) * n * m / 2);
+    parallel(count, count, [&](unsigned int t, std::size_t, std::size_t) {
+        for (unsigned int j = t; j < n; j += count) {
+            for (unsigned int i = 0; i <= j; i++) {
+                int dot = productOf(a + static_cast<std::size_t>(i) * m, a + static_cast<std::size_t>(j) * m, m);
+                out[static_cast<std::size_t>(j) * n + i] = dot;
+                out[static_cast<std::size_t>(i) * n + j] = dot;
+            }
+        }
+    });
+    return result;
+}
+
 /**
 * Creates and returns a new Matrix object that is the power of this.
 * @return a new Matrix object that raises this and to the given power.
@@ -355,7 +880,7 @@ const Matrix Matrix::pow(unsigned int n) const {
     // if number is anything other than 0
     else {
         // put all values from the matrix in the vector
-        std::vector<int> placeHolder(this->A.begin(), this->A.end());
+        std::vector<int> placeHolder(this->A->begin(), this->A->end());
         Matrix result(placeHolder, this->m, this->n);
 
         // traverse thru loop for 'n' times, and multiply the result.
@@ -375,18 +900,1069 @@ const Matrix Matrix::pow(unsigned int n) const {
 * @return a new Matrix object that is the transpose of this object.
 */
 const Matrix Matrix::trans() const {
-    // placeholder empty vector that helps to store values
-    Matrix placeHolder(this->A, this->m, this->n);
-    Matrix result(this->A, this->n, this->m);
+    // element (i, j) of this becomes element (j, i) of the result: each column of this is read front to back and becomes a row
+    Matrix result = zeros(n, m);
+    const int* a = A->data();
+    int* out = result.A->data();
+    for (unsigned int j = 0; j < n; j++) {
+        for (unsigned int i = 0; i < m; i++) {
+            out[i * n + j] = a[j * m + i];
+        }
+    }
+    return result;
+}
+/**
+ * Bareiss fraction-free elimination on the first rows columns of M (rows-by-cols, stored row by row), with row pivoting;
+ * every division is exact, and afterwards M(k, k) is the k-th leading principal minor of the row-permuted matrix.
+ * @param det - receives the determinant of the leading rows-by-rows block, 0 if it is singular (elimination then stops early).
+ * @return false if a value doesn't fit in 64 bits.
+ */
+bool Matrix::bareiss(std::vector<long long>& M, unsigned int rows, unsigned int cols, long long& det) {
+    long long previous = 1;
+    bool negative = false;
+
+    for (unsigned int k = 0; k < rows; k++) {
+        // the smallest non-zero entry at or below the diagonal is the pivot, which keeps the numbers small
+        unsigned int p = rows;
+        for (unsigned int r = k; r < rows; r++) {
+            long long v = M[r * cols + k];
+            if (v != 0 && (p == rows || (v < 0 ? -v : v) < (M[p * cols + k] < 0 ? -M[p * cols + k] : M[p * cols + k]))) {
+                p = r;
+            }
+        }
+        // no pivot means it's singular
+        if (p == rows) {
+            det = 0;
+            return true;
+        }
+        // a row swap flips the sign of the determinant
+        if (p != k) {
+            std::swap_ranges(M.begin() + p * cols, M.begin() + (p + 1) * cols, M.begin() + k * cols);
+            negative = !negative;
+        }
 
-    // traversing thru all elements
-    for (int i = 0; i < this->m; i++) {
-        for (int j = 0; j < this->n; j++) {
-            // rows become columns, and columns become row
-            result.set(i, j, this->get(j, i));
+        // right-looking: every row below takes the pivot row out of itself over the whole trailing block at once,
+        // walking both rows contiguously; (pivot * m_ij - m_ik * m_kj) is always divisible by the previous pivot
+        const long long* pivot = &M[k * cols];
+        for (unsigned int i = k + 1; i < rows; i++) {
+            long long* row = &M[i * cols];
+            long long f = row[k];
+            for (unsigned int j = k + 1; j < cols; j++) {
+                if (!cross(pivot[k], row[j], f, pivot[j], previous, row[j])) {
+                    return false;
+                }
+            }
+            row[k] = 0;
         }
+        previous = pivot[k];
     }
 
-    // return this number
+    det = negative ? -previous : previous;
+    return true;
+}
+
+/**
+ * Creates and returns a new Matrix object that is the element-wise (Hadamard) product of this and the given Matrix object.
+ * Products that don't fit in an int wrap around (mod 2^32), as in mult().
+ * @return a new Matrix object with this(i) * rhs(i) as element i, a 0-by-0 matrix if the sizes don't match.
+ * @param rhs - the Matrix object to multiply with this object element by element.
+ */
+const Matrix Matrix::hadamard(const Matrix& rhs) const {
+    return zip(rhs, [](int x, int y) { return static_cast<int>(static_cast<unsigned int>(x) * static_cast<unsigned int>(y)); }, 0);
+}
+
+/**
+ * Creates and returns a new Matrix object that is the Kronecker product of this (m-by-n) and the given (p-by-q) Matrix object:
+ * the (m*p)-by-(n*q) block matrix whose block (i, j) is this(i, j) * rhs.  Products that don't fit in an int wrap around (mod 2^32), as in mult().
+ * @return a new Matrix object that is the Kronecker product of this and rhs.
+ * @param rhs - the Matrix object to take the Kronecker product with.
+ */
+const Matrix Matrix::kron(const Matrix& rhs) const {
+    unsigned int rows = m * rhs.m, cols = n * rhs.n;
+    Matrix result = zeros(rows, cols);
+    const int* a = A->data();
+    const int* b = rhs.A->data();
+    int* out = result.A->data();
+
+    // column c of the result is column c / q of this with every element i replaced by this(i, c / q) * (column c % q of rhs),
+    // so it's written front to back as m scaled copies of one contiguous column of rhs
+    parallel(cols, pieces(result.A->size()), [&](unsigned int, std::size_t begin, std::size_t end) {
+        for (std::size_t c = begin; c < end; c++) {
+            const int* scale = a + c / rhs.n * m;
+            const int* column = b + c % rhs.n * rhs.m;
+            int* o = out + c * rows;
+            for (unsigned int i = 0; i < m; i++, o += rhs.m) {
+                unsigned int s = static_cast<unsigned int>(scale[i]);
+                for (unsigned int k = 0; k < rhs.m; k++) {
+                    o[k] = static_cast<int>(s * static_cast<unsigned int>(column[k]));
+                }
+            }
+        }
+    });
     return result;
-}
\ No newline at end of file
+}
+
+/**
+ * Calculates the product of kron(B) and x without building kron(B): each column of x, taken column-wise as a matrix X with
+ * B.size(2) rows, gives the column B * X * this^T of the result.  Same as kron(B).mult(x) when it succeeds.
+ * @param B - the right-hand factor of the Kronecker product.
+ * @param x - the Matrix object to multiply with the Kronecker product.
+ * @param result - receives the product, with size(1) * B.size(1) rows and as many columns as x.
+ * @param threads - number of threads to use, 0 for one per core if there is enough work
+ * @return true if the product was calculated, false if x doesn't have size(2) * B.size(2) rows, a value of the product doesn't fit in an int or a sum on the way doesn't fit in 64 bits.
+ */
+bool Matrix::kronMult(const Matrix& B, const Matrix& x, Matrix& result, unsigned int threads) const {
+    if (x.m != n * B.n) {
+        return false;
+    }
+    unsigned int rows = m * B.m;
+    Matrix product = zeros(rows, x.n);
+    const int* a = A->data();
+    const int* b = B.A->data();
+    const int* in = x.A->data();
+    int* out = product.A->data();
+
+    // every partial sum is at most normInf(this) * normInf(B) * max |x| in size; when that fits in 64 bits the sums can be taken
+    // as they are, otherwise every step is checked
+    long long largest = x.A->empty() ? 0 : std::max(std::abs(static_cast<long long>(x.min())), static_cast<long long>(x.max()));
+    long long bound;
+    bool exact = multiply(normInf(), B.normInf(), bound) && multiply(bound, largest, bound);
+
+    // (m*p)(n*q) multiply-adds per column with the product built, only (p*q + m*p) n without it
+    std::size_t work = static_cast<std::size_t>(x.n) * n * (B.m * B.n + rows);
+    unsigned int count = pieces(work, threads);
+    std::vector<char> fits(count, 1);
+    parallel(x.n, count, [&](unsigned int t, std::size_t begin, std::size_t end) {
+        std::vector<long long> T(static_cast<std::size_t>(B.m) * n);
+        std::vector<long long> Y(rows);
+        for (std::size_t j = begin; j < end && fits[t]; j++) {
+            const int* X = in + j * x.m;
+
+            // T = B * X, one contiguous column of B at a time
+            std::fill(T.begin(), T.end(), 0);
+            for (unsigned int l = 0; l < n; l++) {
+                long long* c = T.data() + l * B.m;
+                for (unsigned int k = 0; k < B.n; k++) {
+                    long long v = X[l * B.n + k];
+                    const int* column = b + k * B.m;
+                    if (exact) {
+                        for (unsigned int i = 0; i < B.m; i++) {
+                            c[i] += v * column[i];
+                        }
+                        continue;
+                    }
+                    for (unsigned int i = 0; i < B.m; i++) {
+                        long long term;
+                        if (!multiply(v, column[i], term) || !addTo(c[i], term, c[i])) {
+                            fits[t] = 0;
+                        }
+                    }
+                }
+            }
+
+            // Y = T * this^T: column i of Y is the sum over l of this(i, l) * column l of T
+            std::fill(Y.begin(), Y.end(), 0);
+            for (unsigned int l = 0; l < n; l++) {
+                const long long* c = T.data() + l * B.m;
+                for (unsigned int i = 0; i < m; i++) {
+                    long long v = a[l * m + i];
+                    long long* y = Y.data() + i * B.m;
+                    if (exact) {
+                        for (unsigned int k = 0; k < B.m; k++) {
+                            y[k] += v * c[k];
+                        }
+                        continue;
+                    }
+                    for (unsigned int k = 0; k < B.m; k++) {
+                        long long term;
+                        if (!multiply(v, c[k], term) || !addTo(y[k], term, y[k])) {
+                            fits[t] = 0;
+                        }
+                    }
+                }
+            }
+            int* o = out + j * rows;
+            for (unsigned int r = 0; r < rows; r++) {
+                if (Y[r] > INT_MAX || Y[r] < INT_MIN) {
+                    fits[t] = 0;
+                }
+                o[r] = static_cast<int>(Y[r]);
+            }
+        }
+    });
+    if (std::find(fits.begin(), fits.end(), 0) != fits.end()) {
+        return false;
+    }
+    result = product;
+    return true;
+}
+
+/**
+ * Creates and returns a new Matrix object with the given matrices along its diagonal, in order, and zeros everywhere else.
+ * @return a new Matrix object whose size is the sum of the sizes of the blocks, a 0-by-0 matrix if there are none.
+ * @param blocks - the matrices to put on the diagonal.
+ */
+const Matrix Matrix::blockDiag(const std::vector<Matrix>& blocks) {
+    // the block every column of the result comes from, and where that block starts
+    unsigned int rows = 0, cols = 0;
+    std::vector<unsigned int> owner, top(blocks.size()), left(blocks.size());
+    for (unsigned int b = 0; b < blocks.size(); b++) {
+        top[b] = rows;
+        left[b] = cols;
+        rows += blocks[b].m;
+        cols += blocks[b].n;
+        owner.insert(owner.end(), blocks[b].n, b);
+    }
+    Matrix result = zeros(rows, cols);
+    int* out = result.A->data();
+
+    // every column is a run of zeros, one contiguous column of its block, and more zeros; only the middle part needs writing
+    parallel(cols, pieces(result.A->size()), [&](unsigned int, std::size_t begin, std::size_t end) {
+        for (std::size_t c = begin; c < end; c++) {
+            const Matrix& K = blocks[owner[c]];
+            const int* column = K.A->data() + (c - left[owner[c]]) * K.m;
+            std::copy(column, column + K.m, out + c * rows + top[owner[c]]);
+        }
+    });
+    return result;
+}
+
+/**
+ * Calculates the exact determinant of this matrix by Bareiss fraction-free elimination with row pivoting (O(n^3), no rounding).
+ * @param det - receives the determinant.
+ * @return true if det was calculated, false if this matrix isn't square or a value on the way doesn't fit in 64 bits.
+ */
+bool Matrix::det(long long& det) const {
+    if (m != n) {
+        return false;
+    }
+    // the determinant of a 0-by-0 matrix is the empty product
+    if (n == 0) {
+        det = 1;
+        return true;
+    }
+
+    // row by row copy, so elimination runs along contiguous memory
+    std::vector<long long> M(n * n);
+    for (unsigned int i = 0; i < n; i++) {
+        for (unsigned int j = 0; j < n; j++) {
+            M[i * n + j] = (*A)[j * m + i];
+        }
+    }
+    return bareiss(M, n, n, det);
+}
+
+/**
+ * Solves this * X = B exactly over the rationals: X = num / den, with num an integer matrix and den > 0 sharing no common factor with all of num.
+ * @param B - the right-hand side(s), one per column; must have as many rows as this matrix.
+ * @param num - receives the numerators of X (same size as B).
+ * @param den - receives the common denominator of X.
+ * @return true if X was calculated, false if this matrix isn't square, is singular, B doesn't fit or a value doesn't fit (in 64 bits on the way, in an int at the end).
+ */
+bool Matrix::solve(const Matrix& B, Matrix& num, long long& den) const {
+    if (m != n || n == 0 || B.m != m) {
+        return false;
+    }
+
+    // [this | B], row by row; the right-hand sides are eliminated along with this
+    unsigned int k = B.n;
+    unsigned int w = n + k;
+    std::vector<long long> M(n * w);
+    for (unsigned int i = 0; i < n; i++) {
+        for (unsigned int j = 0; j < n; j++) {
+            M[i * w + j] = (*A)[j * m + i];
+        }
+        for (unsigned int j = 0; j < k; j++) {
+            M[i * w + n + j] = (*B.A)[j * m + i];
+        }
+    }
+    long long d = 0;
+    if (!bareiss(M, n, w, d) || d == 0) {
+        return false;
+    }
+
+    // fraction-free back substitution: X = d * x is an integer matrix (Cramer's rule), with d = M(n-1, n-1) the determinant of the
+    // row-permuted matrix, and X_i = (d * y_i - sum of M(i, j) * X_j over j > i) / M(i, i) divides exactly
+    d = M[(n - 1) * w + n - 1];
+    std::vector<long long> X(n * k);
+    for (unsigned int c = 0; c < k; c++) {
+        for (unsigned int i = n; i-- > 0;) {
+            long long acc;
+            if (!multiply(d, M[i * w + n + c], acc)) {
+                return false;
+            }
+            for (unsigned int j = i + 1; j < n; j++) {
+                long long term;
+                if (!multiply(M[i * w + j], X[j * k + c], term) || !subtract(acc, term, acc)) {
+                    return false;
+                }
+            }
+            X[i * k + c] = acc / M[i * w + i];
+        }
+    }
+
+    // take out the common factor and make the denominator positive
+    long long g = d;
+    for (std::size_t i = 0; i < X.size(); i++) {
+        g = gcd(g, X[i]);
+    }
+    if (d < 0) {
+        g = -g;
+    }
+    den = d / g;
+    std::vector<int> values(n * k);
+    for (unsigned int i = 0; i < n; i++) {
+        for (unsigned int c = 0; c < k; c++) {
+            long long v = X[i * k + c] / g;
+            if (v > INT_MAX || v < INT_MIN) {
+                return false;
+            }
+            values[c * n + i] = static_cast<int>(v);
+        }
+    }
+    num = Matrix(values, n, k);
+    return true;
+}
+
+/**
+ * Calculates the inverse of this matrix exactly over the rationals: the inverse is num / den, as for solve() with the identity matrix.
+ * @param num - receives the numerators of the inverse.
+ * @param den - receives the common denominator of the inverse.
+ * @return true if the inverse was calculated, false if this matrix isn't square, is singular or a value doesn't fit.
+ */
+bool Matrix::inverse(Matrix& num, long long& den) const {
+    std::vector<int> identity(n * n, 0);
+    for (unsigned int i = 0; i < n; i++) {
+        identity[i * n + i] = 1;
+    }
+    return solve(Matrix(identity, n, n), num, den);
+}
+
+/**
+ * Returns true if p is a prime below 32768, so 4 * (p - 1)^2 plus p - 1 fits in 32 bits.
+ */
+bool Matrix::prime(unsigned int p) {
+    if (p < 2 || p > 32767) {
+        return false;
+    }
+    for (unsigned int d = 2; d * d <= p; d++) {
+        if (p % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Copies this matrix row by row into M, with room for extra columns on the right, reduced mod p.
+ */
+void Matrix::rowsMod(std::vector<unsigned int>& M, unsigned int extra, unsigned int p) const {
+    unsigned int w = n + extra;
+    M.assign(m * w, 0);
+    // walk down 16 columns of A (each contiguous) side by side, so every row of M gets 16 values at a time instead of one per column
+    for (unsigned int j0 = 0; j0 < n; j0 += 16) {
+        unsigned int j1 = std::min(n, j0 + 16);
+        for (unsigned int i = 0; i < m; i++) {
+            for (unsigned int j = j0; j < j1; j++) {
+                int v = (*A)[j * m + i] % static_cast<int>(p);
+                M[i * w + j] = static_cast<unsigned int>(v < 0 ? v + static_cast<int>(p) : v);
+            }
+        }
+    }
+}
+
+/**
+ * Brings M (rows-by-cols, stored row by row, elements in [0, p)) to row-echelon form over Z_p on its first limit columns, pivots scaled to 1;
+ * with reduced, entries above the pivots are cleared too.  Pivots are found a panel of rows at a time, and each panel is taken out of the
+ * other rows as one matrix product; rows are only reduced mod p when they could overflow (or become pivot rows).
+ * @param pivots - receives the pivot column of each of the first rank rows.
+ * @param threads - number of threads to split the rows over.
+ * @return the rank of the first limit columns.
+ */
+unsigned int Matrix::echelon(std::vector<unsigned int>& M, unsigned int rows, unsigned int cols, unsigned int limit, unsigned int p, bool reduced, std::vector<unsigned int>& pivots, unsigned int threads) {
+    // every elimination adds at most (p - 1)^2 to an element, so an element below p can take this many before it could overflow
+    // (at least one group of four, as p < 2^15)
+    const unsigned int budget = (0xFFFFFFFFu - (p - 1)) / ((p - 1) * (p - 1));
+    // pivots are found PANEL rows at a time, one row after the other; the rows below then take the whole panel at once, as a
+    // matrix product whose panel stays in cache
+    const unsigned int PANEL = 64;
+    std::vector<unsigned int> adds(rows, 0);
+    AddMultiples kernel = addMultiplesFast();
+    AddProducts product = addProductsFast();
+    // a pivot row that is all zeros, to fill up groups of four
+    std::vector<unsigned int> zero(cols, 0);
+
+    auto reduce = [&](unsigned int* row) {
+        modulo(row, cols, p);
+    };
+
+    // takes pivots [from, to) of list (column, row; by column) out of row i, four at a time; each multiplier is worked out from
+    // the row's entry at that pivot column plus what the pivots before it in the group will add there
+    auto eliminate = [&](unsigned int i, const std::vector<std::pair<unsigned int, unsigned int> >& list, std::size_t from, std::size_t to) {
+        unsigned int* row = &M[i * cols];
+        for (std::size_t a = from; a < to; a += 4) {
+            if (adds[i] > budget - 4) {
+                reduce(row);
+                adds[i] = 0;
+            }
+            adds[i] += 4;
+            const unsigned int* pivot[4];
+            unsigned int g[4];
+            for (std::size_t b = 0; b < 4; b++) {
+                if (a + b >= to) {
+                    pivot[b] = zero.data();
+                    g[b] = 0;
+                    continue;
+                }
+                unsigned int c = list[a + b].first;
+                pivot[b] = &M[list[a + b].second * cols];
+                unsigned int v = row[c];
+                for (std::size_t e = 0; e < b; e++) {
+                    v += g[e] * pivot[e][c];
+                }
+                g[b] = (p - v % p) % p;
+            }
+            kernel(row, pivot, g, list[a].first, cols);
+        }
+    };
+
+    // takes all the pivots of list out of the rows targets as one product, on up to threads threads.  The pivot rows must be reduced
+    // and zero at each other's pivot columns, so every multiplier can be read off before any of them is applied.  pending is the number
+    // of terms the targets have taken since they were last reduced: they are reduced mod p whenever the next pair would not fit
+    auto update = [&](const std::vector<unsigned int>& targets, const std::vector<std::pair<unsigned int, unsigned int> >& list, unsigned int& pending) {
+        if (targets.empty() || list.empty()) {
+            return;
+        }
+        // the pivot rows are zero left of the first pivot column
+        unsigned int from = list.front().first, width = cols - from;
+        unsigned int pairs = static_cast<unsigned int>((list.size() + 1) / 2);
+        std::vector<unsigned short> panel(static_cast<std::size_t>(pairs) * 2 * width, 0);
+        for (std::size_t t = 0; t < list.size(); t++) {
+            const unsigned int* pivot = &M[list[t].second * cols + from];
+            unsigned short* out = &panel[(t / 2) * 2 * width + t % 2];
+            for (unsigned int k = 0; k < width; k++) {
+                out[2 * k] = static_cast<unsigned short>(pivot[k]);
+            }
+        }
+        std::vector<unsigned int> g(targets.size() * pairs, 0);
+        std::vector<unsigned int*> part(targets.size());
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            const unsigned int* row = &M[targets[i] * cols];
+            part[i] = &M[targets[i] * cols + from];
+            for (std::size_t t = 0; t < list.size(); t++) {
+                g[i * pairs + t / 2] |= (p - row[list[t].first] % p) % p << (16 * (t % 2));
+            }
+        }
+
+        // the pairs go in runs that fit in the budget, a pair being two terms; start[s] is the first pair of run s
+        std::vector<unsigned int> start;
+        std::vector<char> reduceFirst;
+        for (unsigned int q = 0; q < pairs;) {
+            reduceFirst.push_back(pending > budget - 2);
+            if (reduceFirst.back()) {
+                pending = 0;
+            }
+            start.push_back(q);
+            unsigned int run = std::min(pairs - q, (budget - pending) / 2);
+            pending += 2 * run;
+            q += run;
+        }
+        start.push_back(pairs);
+
+        unsigned int count = static_cast<unsigned int>(std::min<std::size_t>(threads, std::max<std::size_t>(1, targets.size() / 16)));
+        parallel(targets.size(), count, [&](unsigned int, std::size_t begin, std::size_t end) {
+            for (std::size_t s = 0; s + 1 < start.size(); s++) {
+                if (reduceFirst[s]) {
+                    for (std::size_t i = begin; i < end; i++) {
+                        reduce(&M[targets[i] * cols]);
+                    }
+                }
+                product(&part[begin], static_cast<unsigned int>(end - begin), &g[begin * pairs + start[s]], pairs,
+                        &panel[static_cast<std::size_t>(start[s]) * 2 * width], start[s + 1] - start[s], width, 0, width);
+            }
+        });
+    };
+
+    // pivot column and row of every pivot found so far, by column, and the same for each panel on its own; taking pivots in column order
+    // is what keeps earlier columns clear, since a pivot row is zero left of its pivot column and at every other pivot column found before it
+    std::vector<std::pair<unsigned int, unsigned int> > found;
+    std::vector<std::vector<std::pair<unsigned int, unsigned int> > > panels;
+    // terms the rows below the current panel have taken since they were last reduced
+    unsigned int pending = 0;
+
+    for (unsigned int r0 = 0; r0 < rows; r0 += PANEL) {
+        unsigned int r1 = std::min(rows, r0 + PANEL);
+
+        // the rows of the panel already have every earlier panel taken out; one row at a time against the pivots found in this one
+        std::vector<std::pair<unsigned int, unsigned int> > panel;
+        for (unsigned int i = r0; i < r1; i++) {
+            unsigned int* row = &M[i * cols];
+            adds[i] = pending;
+            eliminate(i, panel, 0, panel.size());
+            reduce(row);
+            unsigned int c = 0;
+            while (c < limit && row[c] == 0) {
+                c++;
+            }
+            // nothing left in the first limit columns: not a pivot row
+            if (c == limit) {
+                continue;
+            }
+            unsigned int inverse = inverseMod(row[c], p);
+            for (unsigned int k = c; k < cols; k++) {
+                row[k] = row[k] * inverse % p;
+            }
+            panel.insert(std::upper_bound(panel.begin(), panel.end(), std::make_pair(c, i)), std::make_pair(c, i));
+        }
+
+        // clear the panel's pivot columns in its own pivot rows, last pivot first, so the rows below can take it as a product
+        for (std::size_t v = panel.size(); v-- > 0;) {
+            adds[panel[v].second] = 0;
+            eliminate(panel[v].second, panel, v + 1, panel.size());
+            reduce(&M[panel[v].second * cols]);
+        }
+        std::vector<unsigned int> below;
+        for (unsigned int i = r1; i < rows; i++) {
+            below.push_back(i);
+        }
+        update(below, panel, pending);
+
+        std::vector<std::pair<unsigned int, unsigned int> > merged(found.size() + panel.size());
+        std::merge(found.begin(), found.end(), panel.begin(), panel.end(), merged.begin());
+        found.swap(merged);
+        panels.push_back(panel);
+    }
+
+    // reduced form: clear above the pivots a panel at a time, last panel first; its rows are already clear of every later panel, so
+    // the pivot rows of all the earlier panels take it as one product
+    unsigned int rank = static_cast<unsigned int>(found.size());
+    if (reduced) {
+        unsigned int back = 0;
+        for (std::size_t q = panels.size(); q-- > 1;) {
+            for (std::size_t v = 0; v < panels[q].size(); v++) {
+                reduce(&M[panels[q][v].second * cols]);
+            }
+            std::vector<unsigned int> above;
+            for (std::size_t e = 0; e < q; e++) {
+                for (std::size_t v = 0; v < panels[e].size(); v++) {
+                    above.push_back(panels[e][v].second);
+                }
+            }
+            update(above, panels[q], back);
+        }
+        // every row but those of the last panel took the last product, and every other row is reduced already
+        if (back > 0) {
+            for (std::size_t e = 0; e + 1 < panels.size(); e++) {
+                for (std::size_t v = 0; v < panels[e].size(); v++) {
+                    reduce(&M[panels[e][v].second * cols]);
+                }
+            }
+        }
+    }
+
+    // pivot rows in column order on top, then the others as they were: row order[i] goes to row i, moved in place one cycle at a time
+    pivots.clear();
+    std::vector<unsigned int> order;
+    std::vector<char> used(rows, 0);
+    for (std::size_t f = 0; f < found.size(); f++) {
+        pivots.push_back(found[f].first);
+        order.push_back(found[f].second);
+        used[found[f].second] = 1;
+    }
+    for (unsigned int i = 0; i < rows; i++) {
+        if (!used[i]) {
+            order.push_back(i);
+        }
+    }
+    std::vector<unsigned int> first(cols);
+    std::vector<char> moved(rows, 0);
+    for (unsigned int i = 0; i < rows; i++) {
+        if (moved[i] || order[i] == i) {
+            continue;
+        }
+        std::copy(M.begin() + i * cols, M.begin() + (i + 1) * cols, first.begin());
+        unsigned int at = i;
+        for (; order[at] != i; at = order[at]) {
+            std::copy(M.begin() + order[at] * cols, M.begin() + (order[at] + 1) * cols, M.begin() + at * cols);
+            moved[at] = 1;
+        }
+        std::copy(first.begin(), first.end(), M.begin() + at * cols);
+        moved[at] = 1;
+    }
+    return rank;
+}
+
+/**
+ * Creates and returns the reduced row-echelon form of this matrix over Z_p (elements are reduced mod p first).
+ * @param p - a prime below 32768.
+ * @param threads - number of threads to use, 1 for the calling thread only, 0 for one per core if the matrix is big enough
+ * @return a new Matrix object with the reduced row-echelon form, elements in [0, p); a 0-by-0 matrix if p isn't such a prime.
+ */
+const Matrix Matrix::rref(unsigned int p, unsigned int threads) const {
+    if (!prime(p)) {
+        return Matrix({}, 0, 0);
+    }
+    std::vector<unsigned int> M;
+    std::vector<unsigned int> pivots;
+    rowsMod(M, 0, p);
+    echelon(M, m, n, n, p, true, pivots, pieces(M.size(), threads));
+
+    // back to columns, 16 rows of M side by side so every column of the result gets 16 values at a time
+    Matrix result = zeros(m, n);
+    int* values = result.A->data();
+    for (unsigned int i0 = 0; i0 < m; i0 += 16) {
+        unsigned int i1 = std::min(m, i0 + 16);
+        for (unsigned int j = 0; j < n; j++) {
+            for (unsigned int i = i0; i < i1; i++) {
+                values[j * m + i] = static_cast<int>(M[i * n + j]);
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Calculates the rank of this matrix over Z_p.
+ * @param p - a prime below 32768.
+ * @param rank - receives the rank.
+ * @param threads - number of threads to use, 1 for the calling thread only, 0 for one per core if the matrix is big enough
+ * @return true if the rank was calculated, false if p isn't such a prime.
+ */
+bool Matrix::rank(unsigned int p, unsigned int& rank, unsigned int threads) const {
+    if (!prime(p)) {
+        return false;
+    }
+    // the plain echelon form is enough, which skips the products that clear above the pivots
+    std::vector<unsigned int> M;
+    std::vector<unsigned int> pivots;
+    rowsMod(M, 0, p);
+    rank = echelon(M, m, n, n, p, false, pivots, pieces(M.size(), threads));
+    return true;
+}
+
+/**
+ * Creates and returns a basis of the nullspace of this matrix over Z_p, i.e. of all x with this * x = 0 (mod p).
+ * @param p - a prime below 32768.
+ * @param threads - number of threads to use, 1 for the calling thread only, 0 for one per core if the matrix is big enough
+ * @return a new n-by-k Matrix object whose k columns are the basis (k = n - rank; n-by-0 if only x = 0 works); a 0-by-0 matrix if p isn't such a prime.
+ */
+const Matrix Matrix::nullspace(unsigned int p, unsigned int threads) const {
+    if (!prime(p)) {
+        return Matrix({}, 0, 0);
+    }
+    std::vector<unsigned int> M;
+    std::vector<unsigned int> pivots;
+    rowsMod(M, 0, p);
+    unsigned int r = echelon(M, m, n, n, p, true, pivots, pieces(M.size(), threads));
+
+    // one basis vector per free column f: x_f = 1, and each pivot variable cancels its row's entry in column f
+    std::vector<int> basis;
+    basis.reserve(n * (n - r));
+    unsigned int next = 0;
+    for (unsigned int f = 0; f < n; f++) {
+        if (next < r && pivots[next] == f) {
+            next++;
+            continue;
+        }
+        std::vector<int> x(n, 0);
+        x[f] = 1;
+        for (unsigned int i = 0; i < r; i++) {
+            x[pivots[i]] = static_cast<int>((p - M[i * n + f]) % p);
+        }
+        basis.insert(basis.end(), x.begin(), x.end());
+    }
+    return Matrix(basis, n, n - r);
+}
+
+/**
+ * Solves this * X = B over Z_p; when there are many solutions the one with all free variables 0 is returned (add nullspace(p) for the others).
+ * @param B - the right-hand side(s), one per column; must have as many rows as this matrix.
+ * @param p - a prime below 32768.
+ * @param X - receives a solution, elements in [0, p).
+ * @param threads - number of threads to use, 1 for the calling thread only, 0 for one per core if the matrix is big enough
+ * @return true if a solution was found, false if there is none, B doesn't fit or p isn't such a prime.
+ */
+bool Matrix::solve(const Matrix& B, unsigned int p, Matrix& X, unsigned int threads) const {
+    if (!prime(p) || B.m != m) {
+        return false;
+    }
+
+    // [this | B], row by row, eliminated on the columns of this only
+    unsigned int k = B.n;
+    unsigned int w = n + k;
+    std::vector<unsigned int> M;
+    std::vector<unsigned int> pivots;
+    rowsMod(M, k, p);
+    for (unsigned int c = 0; c < k; c++) {
+        for (unsigned int i = 0; i < m; i++) {
+            int v = (*B.A)[c * m + i] % static_cast<int>(p);
+            M[i * w + n + c] = static_cast<unsigned int>(v < 0 ? v + static_cast<int>(p) : v);
+        }
+    }
+    unsigned int r = echelon(M, m, w, n, p, true, pivots, pieces(M.size(), threads));
+
+    // a zero row of this with something left on the right means there is no solution
+    for (unsigned int i = r; i < m; i++) {
+        for (unsigned int c = 0; c < k; c++) {
+            if (M[i * w + n + c] != 0) {
+                return false;
+            }
+        }
+    }
+
+    std::vector<int> values(n * k, 0);
+    for (unsigned int i = 0; i < r; i++) {
+        for (unsigned int c = 0; c < k; c++) {
+            values[c * n + pivots[i]] = static_cast<int>(M[i * w + n + c]);
+        }
+    }
+    X = Matrix(values, n, k);
+    return true;
+}
+
+/**
+ * Returns the sum of all elements.
+ * @return the sum, 0 for an empty matrix.
+ */
+long long Matrix::sum() const {
+    // the elements are one contiguous column-wise run; big matrices are cut into one piece per thread
+    const int* a = A->data();
+    std::size_t size = A->size();
+    unsigned int count = pieces(size);
+    std::vector<long long> partial(count, 0);
+    parallel(size, count, [&](unsigned int t, std::size_t begin, std::size_t end) {
+        partial[t] = sumOf(a + begin, end - begin);
+    });
+    long long total = 0;
+    for (unsigned int t = 0; t < count; t++) {
+        total += partial[t];
+    }
+    return total;
+}
+
+/**
+ * Returns the smallest element.
+ * @return the smallest element, or smallest possible value for int if the matrix is empty.
+ */
+int Matrix::min() const {
+    if (A->empty()) {
+        return INT_MIN;
+    }
+    const int* a = A->data();
+    std::size_t size = A->size();
+    unsigned int count = pieces(size);
+    std::vector<int> partial(count, INT_MAX);
+    parallel(size, count, [&](unsigned int t, std::size_t begin, std::size_t end) {
+        if (end > begin) {
+            partial[t] = extremeOf(a + begin, end - begin, true);
+        }
+    });
+    return *std::min_element(partial.begin(), partial.end());
+}
+
+/**
+ * Returns the largest element.
+ * @return the largest element, or smallest possible value for int if the matrix is empty.
+ */
+int Matrix::max() const {
+    if (A->empty()) {
+        return INT_MIN;
+    }
+    const int* a = A->data();
+    std::size_t size = A->size();
+    unsigned int count = pieces(size);
+    std::vector<int> partial(count, INT_MIN);
+    parallel(size, count, [&](unsigned int t, std::size_t begin, std::size_t end) {
+        if (end > begin) {
+            partial[t] = extremeOf(a + begin, end - begin, false);
+        }
+    });
+    return *std::max_element(partial.begin(), partial.end());
+}
+
+/**
+ * Returns where the smallest element is (the first one, column-wise, if there are several).
+ * @return column-wise (linear) index of the smallest element, 0 if the matrix is empty.
+ */
+unsigned int Matrix::argmin() const {
+    // find the value with the fast reduction first, then look for it; that scan stops at the first hit
+    if (A->empty()) {
+        return 0;
+    }
+    return static_cast<unsigned int>(find(A->data(), A->size(), min()));
+}
+
+/**
+ * Returns where the largest element is (the first one, column-wise, if there are several).
+ * @return column-wise (linear) index of the largest element, 0 if the matrix is empty.
+ */
+unsigned int Matrix::argmax() const {
+    if (A->empty()) {
+        return 0;
+    }
+    return static_cast<unsigned int>(find(A->data(), A->size(), max()));
+}
+
+/**
+ * Returns the trace, the sum of the elements on the diagonal.
+ * @return the trace, 0 for an empty matrix (non-square matrices use their min(m, n) diagonal elements).
+ */
+long long Matrix::trace() const {
+    long long total = 0;
+    // the diagonal is every (m + 1)-th element
+    for (unsigned int i = 0; i < m && i < n; i++) {
+        total += (*A)[i * (m + 1)];
+    }
+    return total;
+}
+
+/**
+ * Returns the L1 norm: the largest sum of absolute values of a column.
+ * @return the L1 norm, 0 for an empty matrix.
+ */
+long long Matrix::norm1() const {
+    // each column is contiguous; big matrices give each thread a range of columns
+    const int* a = A->data();
+    unsigned int count = pieces(A->size());
+    std::vector<long long> partial(count, 0);
+    parallel(n, count, [&](unsigned int t, std::size_t begin, std::size_t end) {
+        for (std::size_t j = begin; j < end; j++) {
+            partial[t] = std::max(partial[t], absSumOf(a + j * m, m));
+        }
+    });
+    return *std::max_element(partial.begin(), partial.end());
+}
+
+/**
+ * Returns the L-infinity norm: the largest sum of absolute values of a row.
+ * @return the L-infinity norm, 0 for an empty matrix.
+ */
+long long Matrix::normInf() const {
+    // rows aren't contiguous, so add whole columns into one running sum per row instead of walking along each row
+    const int* a = A->data();
+    std::vector<long long> rows(m, 0);
+    unsigned int count = pieces(A->size());
+    parallel(m, count, [&](unsigned int, std::size_t begin, std::size_t end) {
+        long long* acc = rows.data();
+        for (unsigned int j = 0; j < n; j++) {
+            const int* column = a + j * m;
+            for (std::size_t i = begin; i < end; i++) {
+                acc[i] += std::llabs(column[i]);
+            }
+        }
+    });
+    return rows.empty() ? 0 : *std::max_element(rows.begin(), rows.end());
+}
+
+/**
+ * Returns the dot (Frobenius inner) product of this and rhs: the sum of the products of corresponding elements.
+ * @param rhs - the Matrix object to take the dot product with; must be the same size as this.
+ * @return the dot product, or smallest possible value for long long if the sizes don't match.
+ */
+long long Matrix::dot(const Matrix& rhs) const {
+    if (m != rhs.m || n != rhs.n) {
+        return LLONG_MIN;
+    }
+    const int* a = A->data();
+    const int* b = rhs.A->data();
+    std::size_t size = A->size();
+    unsigned int count = pieces(size);
+    std::vector<long long> partial(count, 0);
+    parallel(size, count, [&](unsigned int t, std::size_t begin, std::size_t end) {
+        partial[t] = dotOf(a + begin, b + begin, end - begin);
+    });
+    long long total = 0;
+    for (unsigned int t = 0; t < count; t++) {
+        total += partial[t];
+    }
+    return total;
+}
+
+/**
+ * Returns the sum of each column (dim = 1) or of each row (dim = 2), in 64 bits like sum().
+ * @param dim - 1 to add up along the rows (per column), 2 to add up along the columns (per row)
+ * @return one sum per column or row, empty if dim isn't valid.
+ */
+std::vector<long long> Matrix::sums(unsigned int dim) const {
+    const int* a = A->data();
+    unsigned int count = pieces(A->size());
+
+    // per column: each column is a contiguous run
+    if (dim == 1) {
+        std::vector<long long> result(n);
+        parallel(n, count, [&](unsigned int, std::size_t begin, std::size_t end) {
+            for (std::size_t j = begin; j < end; j++) {
+                result[j] = sumOf(a + j * m, m);
+            }
+        });
+        return result;
+    }
+
+    // per row: add whole columns into one running sum per row
+    else if (dim == 2) {
+        std::vector<long long> result(m, 0);
+        parallel(m, count, [&](unsigned int, std::size_t begin, std::size_t end) {
+            for (unsigned int j = 0; j < n; j++) {
+                const int* column = a + j * m;
+                for (std::size_t i = begin; i < end; i++) {
+                    result[i] += column[i];
+                }
+            }
+        });
+        return result;
+    }
+    return std::vector<long long>();
+}
+
+/**
+ * Creates and returns the smallest element of each column (dim = 1, a 1-by-n matrix) or of each row (dim = 2, an m-by-1 matrix).
+ * @param dim - 1 per column, 2 per row
+ * @return a new Matrix object with the smallest elements, a 0-by-0 matrix if dim isn't valid.
+ */
+const Matrix Matrix::mins(unsigned int dim) const {
+    std::vector<unsigned int> where = argmins(dim);
+    if (dim != 1 && dim != 2) {
+        return Matrix({}, 0, 0);
+    }
+    std::vector<int> result(where.size());
+    for (unsigned int k = 0; k < where.size(); k++) {
+        result[k] = dim == 1 ? get(where[k], k) : get(k, where[k]);
+    }
+    return dim == 1 ? Matrix(result, 1, n) : Matrix(result, m, 1);
+}
+
+/**
+ * Creates and returns the largest element of each column (dim = 1, a 1-by-n matrix) or of each row (dim = 2, an m-by-1 matrix).
+ * @param dim - 1 per column, 2 per row
+ * @return a new Matrix object with the largest elements, a 0-by-0 matrix if dim isn't valid.
+ */
+const Matrix Matrix::maxs(unsigned int dim) const {
+    std::vector<unsigned int> where = argmaxs(dim);
+    if (dim != 1 && dim != 2) {
+        return Matrix({}, 0, 0);
+    }
+    std::vector<int> result(where.size());
+    for (unsigned int k = 0; k < where.size(); k++) {
+        result[k] = dim == 1 ? get(where[k], k) : get(k, where[k]);
+    }
+    return dim == 1 ? Matrix(result, 1, n) : Matrix(result, m, 1);
+}
+
+/**
+ * Returns where the smallest element of each column (dim = 1: its row) or of each row (dim = 2: its column) is; the first one if there are several.
+ * @param dim - 1 per column, 2 per row
+ * @return one index per column or row, empty if dim isn't valid.
+ */
+std::vector<unsigned int> Matrix::argmins(unsigned int dim) const {
+    return extremes(dim, true);
+}
+
+/**
+ * Returns where the largest element of each column (dim = 1: its row) or of each row (dim = 2: its column) is; the first one if there are several.
+ * @param dim - 1 per column, 2 per row
+ * @return one index per column or row, empty if dim isn't valid.
+ */
+std::vector<unsigned int> Matrix::argmaxs(unsigned int dim) const {
+    return extremes(dim, false);
+}
+
+/**
+ * Returns where the smallest (less = true) or largest element of each column (dim = 1) or row (dim = 2) is, as for argmins/argmaxs.
+ */
+std::vector<unsigned int> Matrix::extremes(unsigned int dim, bool less) const {
+    const int* a = A->data();
+    unsigned int count = pieces(A->size());
+
+    // per column: the fast reduction down the contiguous column, then look for the value
+    if (dim == 1) {
+        std::vector<unsigned int> result(n, 0);
+        parallel(n, count, [&](unsigned int, std::size_t begin, std::size_t end) {
+            for (std::size_t j = begin; m > 0 && j < end; j++) {
+                const int* column = a + j * m;
+                result[j] = static_cast<unsigned int>(find(column, m, extremeOf(column, m, less)));
+            }
+        });
+        return result;
+    }
+
+    // per row: keep the best so far for every row and sweep the columns; strict comparisons keep the first one
+    else if (dim == 2) {
+        std::vector<unsigned int> result(m, 0);
+        std::vector<int> best(a, a + (n > 0 ? m : 0));
+        best.resize(m, 0);
+        parallel(m, count, [&](unsigned int, std::size_t begin, std::size_t end) {
+            for (unsigned int j = 1; j < n; j++) {
+                const int* column = a + j * m;
+                for (std::size_t i = begin; i < end; i++) {
+                    bool better = less ? column[i] < best[i] : column[i] > best[i];
+                    best[i] = better ? column[i] : best[i];
+                    result[i] = better ? j : result[i];
+                }
+            }
+        });
+        return result;
+    }
+    return std::vector<unsigned int>();
+}
+
+/**
+ * Returns the dot product of each column of this with the same column of rhs (dim = 1), or of each row with the same row (dim = 2).
+ * @param rhs - the Matrix object to take the dot products with; must be the same size as this.
+ * @param dim - 1 per column, 2 per row
+ * @return one dot product per column or row, empty if dim isn't valid or the sizes don't match.
+ */
+std::vector<long long> Matrix::dots(const Matrix& rhs, unsigned int dim) const {
+    if (m != rhs.m || n != rhs.n) {
+        return std::vector<long long>();
+    }
+    const int* a = A->data();
+    const int* b = rhs.A->data();
+    unsigned int count = pieces(A->size());
+
+    if (dim == 1) {
+        std::vector<long long> result(n);
+        parallel(n, count, [&](unsigned int, std::size_t begin, std::size_t end) {
+            for (std::size_t j = begin; j < end; j++) {
+                result[j] = dotOf(a + j * m, b + j * m, m);
+            }
+        });
+        return result;
+    }
+    else if (dim == 2) {
+        std::vector<long long> result(m, 0);
+        parallel(m, count, [&](unsigned int, std::size_t begin, std::size_t end) {
+            for (unsigned int j = 0; j < n; j++) {
+                const int* x = a + j * m;
+                const int* y = b + j * m;
+                for (std::size_t i = begin; i < end; i++) {
+                    result[i] += static_cast<long long>(x[i]) * y[i];
+                }
+            }
+        });
+        return result;
+    }
+    return std::vector<long long>();
+}
+
+/**
+ * Returns how many threads to give a job on this many elements: threads itself (at most one per element), or for 0 one per core
+ * if there are enough elements to be worth it.
+ */
+unsigned int Matrix::pieces(std::size_t elements, unsigned int threads) {
+    if (threads != 0) {
+        return static_cast<unsigned int>(std::max<std::size_t>(1, std::min<std::size_t>(threads, elements)));
+    }
+    std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<unsigned int>(std::max<std::size_t>(1, std::min(cores, elements / PARALLEL_MIN)));
+}
+
+/**
+ * Returns an m-by-n matrix of zeros with its own elements, ready to be written through A->data().
+ */
+Matrix Matrix::zeros(unsigned int m, unsigned int n) {
+    Matrix result({}, 0, 0);
+    result.m = m;
+    result.n = n;
+    result.A = std::make_shared<std::vector<int> >(static_cast<std::size_t>(m) * n);
+    return result;
+}
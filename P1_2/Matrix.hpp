@@ -1,11 +1,19 @@
 #ifndef _MATRIX_HPP_
 #define _MATRIX_HPP_
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
 
 /**
  * This is a basic C++ class to represent two-dimensional matrices.  It's not meant to be difficult but as a refresher on classes.
+ * Copies share their elements until one of them is modified (copy-on-write), so passing or returning a Matrix by value is cheap.
+ * Copies that share elements may be used and written from different threads: a write only happens in place once every other
+ * copy is gone, and is ordered after everything the threads that dropped them did.  A single Matrix object is no more thread-safe
+ * than an int: don't write it while another thread uses it.
  */ 
 class Matrix
 {
@@ -45,6 +53,12 @@ public:
    */ 
   int get(unsigned int i, unsigned int j) const;
 
+  /**
+   * Returns a pointer to the elements, stored column-wise; valid until this object is modified or destroyed.
+   * @return pointer to the first of size(1) * size(2) elements.
+   */ 
+  const int* data() const;
+
   /**
    * Sets the element at specified linear index i to given value; if index is invalid matrix should not be modified.
    * @param i - column-wise (linear) index of object to set.
@@ -104,6 +118,23 @@ public:
    */
   const Matrix mult( int c ) const;
 
+  /**
+   * Creates and returns a new Matrix object that is op(this) * op(rhs), where op transposes its matrix if the matching flag is set;
+   * the transposes are never built, the column-wise layout is read the way each product needs it.
+   * @return a new Matrix object with the product, a 0-by-0 matrix if the (transposed) matrices can't be multiplied.
+   * @param rhs - the Matrix object to multiply with this object.
+   * @param transThis - true to multiply with this^T instead of this.
+   * @param transRhs - true to multiply with rhs^T instead of rhs.
+   */
+  const Matrix mult( const Matrix &rhs, bool transThis, bool transRhs ) const;
+
+  /**
+   * Creates and returns the Gram matrix this^T * this, the dot products of every pair of columns; only half of it is computed,
+   * the other half is the same by symmetry.
+   * @return a new n-by-n Matrix object that is this^T * this.
+   */
+  const Matrix gram() const;
+
   /**
    * Creates and returns a new Matrix object that is the power of this.
    * @return a new Matrix object that raises this and to the given power.
@@ -116,6 +147,225 @@ public:
    * @return a new Matrix object that is the transpose of this object.
    */
   const Matrix trans() const;
+
+  /**
+   * Creates and returns a new Matrix object that is the element-wise (Hadamard) product of this and the given Matrix object.
+   * Products that don't fit in an int wrap around (mod 2^32), as in mult().
+   * @return a new Matrix object with this(i) * rhs(i) as element i, a 0-by-0 matrix if the sizes don't match.
+   * @param rhs - the Matrix object to multiply with this object element by element.
+   */
+  const Matrix hadamard( const Matrix &rhs ) const;
+
+  /**
+   * Creates and returns a new Matrix object that is the Kronecker product of this (m-by-n) and the given (p-by-q) Matrix object:
+   * the (m*p)-by-(n*q) block matrix whose block (i, j) is this(i, j) * rhs.  Products that don't fit in an int wrap around (mod 2^32), as in mult().
+   * @return a new Matrix object that is the Kronecker product of this and rhs.
+   * @param rhs - the Matrix object to take the Kronecker product with.
+   */
+  const Matrix kron( const Matrix &rhs ) const;
+
+  /**
+   * Calculates the product of kron(B) and x without building kron(B): each column of x, taken column-wise as a matrix X with
+   * B.size(2) rows, gives the column B * X * this^T of the result.  Same as kron(B).mult(x) when it succeeds.
+   * @param B - the right-hand factor of the Kronecker product.
+   * @param x - the Matrix object to multiply with the Kronecker product.
+   * @param result - receives the product, with size(1) * B.size(1) rows and as many columns as x.
+   * @param threads - number of threads to use, 0 (the default) for one per core if there is enough work
+   * @return true if the product was calculated, false if x doesn't have size(2) * B.size(2) rows, a value of the product doesn't fit in an int or a sum on the way doesn't fit in 64 bits.
+   */
+  bool kronMult( const Matrix &B, const Matrix &x, Matrix &result, unsigned int threads = 0 ) const;
+
+  /**
+   * Creates and returns a new Matrix object with the given matrices along its diagonal, in order, and zeros everywhere else.
+   * @return a new Matrix object whose size is the sum of the sizes of the blocks, a 0-by-0 matrix if there are none.
+   * @param blocks - the matrices to put on the diagonal.
+   */
+  static const Matrix blockDiag( const std::vector<Matrix> &blocks );
+
+  /**
+   * Calculates the exact determinant of this matrix by Bareiss fraction-free elimination with row pivoting (O(n^3), no rounding).
+   * @param det - receives the determinant.
+   * @return true if det was calculated, false if this matrix isn't square or a value on the way doesn't fit in 64 bits.
+   */
+  bool det( long long &det ) const;
+
+  /**
+   * Solves this * X = B exactly over the rationals: X = num / den, with num an integer matrix and den > 0 sharing no common factor with all of num.
+   * @param B - the right-hand side(s), one per column; must have as many rows as this matrix.
+   * @param num - receives the numerators of X (same size as B).
+   * @param den - receives the common denominator of X.
+   * @return true if X was calculated, false if this matrix isn't square, is singular, B doesn't fit or a value doesn't fit (in 64 bits on the way, in an int at the end).
+   */
+  bool solve( const Matrix &B, Matrix &num, long long &den ) const;
+
+  /**
+   * Calculates the inverse of this matrix exactly over the rationals: the inverse is num / den, as for solve() with the identity matrix.
+   * @param num - receives the numerators of the inverse.
+   * @param den - receives the common denominator of the inverse.
+   * @return true if the inverse was calculated, false if this matrix isn't square, is singular or a value doesn't fit.
+   */
+  bool inverse( Matrix &num, long long &den ) const;
+
+  /**
+   * Creates and returns the reduced row-echelon form of this matrix over Z_p (elements are reduced mod p first).
+   * @param p - a prime below 32768.
+   * @param threads - number of threads to use, 1 (the default) for the calling thread only, 0 for one per core if the matrix is big enough
+   * @return a new Matrix object with the reduced row-echelon form, elements in [0, p); a 0-by-0 matrix if p isn't such a prime.
+   */
+  const Matrix rref( unsigned int p, unsigned int threads = 1 ) const;
+
+  /**
+   * Calculates the rank of this matrix over Z_p.
+   * @param p - a prime below 32768.
+   * @param rank - receives the rank.
+   * @param threads - number of threads to use, 1 (the default) for the calling thread only, 0 for one per core if the matrix is big enough
+   * @return true if the rank was calculated, false if p isn't such a prime.
+   */
+  bool rank( unsigned int p, unsigned int &rank, unsigned int threads = 1 ) const;
+
+  /**
+   * Creates and returns a basis of the nullspace of this matrix over Z_p, i.e. of all x with this * x = 0 (mod p).
+   * @param p - a prime below 32768.
+   * @param threads - number of threads to use, 1 (the default) for the calling thread only, 0 for one per core if the matrix is big enough
+   * @return a new n-by-k Matrix object whose k columns are the basis (k = n - rank; n-by-0 if only x = 0 works); a 0-by-0 matrix if p isn't such a prime.
+   */
+  const Matrix nullspace( unsigned int p, unsigned int threads = 1 ) const;
+
+  /**
+   * Solves this * X = B over Z_p; when there are many solutions the one with all free variables 0 is returned (add nullspace(p) for the others).
+   * @param B - the right-hand side(s), one per column; must have as many rows as this matrix.
+   * @param p - a prime below 32768.
+   * @param X - receives a solution, elements in [0, p).
+   * @param threads - number of threads to use, 1 (the default) for the calling thread only, 0 for one per core if the matrix is big enough
+   * @return true if a solution was found, false if there is none, B doesn't fit or p isn't such a prime.
+   */
+  bool solve( const Matrix &B, unsigned int p, Matrix &X, unsigned int threads = 1 ) const;
+
+  /**
+   * Returns the sum of all elements.
+   * @return the sum, 0 for an empty matrix.
+   */
+  long long sum() const;
+
+  /**
+   * Returns the smallest element.
+   * @return the smallest element, or smallest possible value for int if the matrix is empty.
+   */
+  int min() const;
+
+  /**
+   * Returns the largest element.
+   * @return the largest element, or smallest possible value for int if the matrix is empty.
+   */
+  int max() const;
+
+  /**
+   * Returns where the smallest element is (the first one, column-wise, if there are several).
+   * @return column-wise (linear) index of the smallest element, 0 if the matrix is empty.
+   */
+  unsigned int argmin() const;
+
+  /**
+   * Returns where the largest element is (the first one, column-wise, if there are several).
+   * @return column-wise (linear) index of the largest element, 0 if the matrix is empty.
+   */
+  unsigned int argmax() const;
+
+  /**
+   * Returns the trace, the sum of the elements on the diagonal.
+   * @return the trace, 0 for an empty matrix (non-square matrices use their min(m, n) diagonal elements).
+   */
+  long long trace() const;
+
+  /**
+   * Returns the L1 norm: the largest sum of absolute values of a column.
+   * @return the L1 norm, 0 for an empty matrix.
+   */
+  long long norm1() const;
+
+  /**
+   * Returns the L-infinity norm: the largest sum of absolute values of a row.
+   * @return the L-infinity norm, 0 for an empty matrix.
+   */
+  long long normInf() const;
+
+  /**
+   * Returns the dot (Frobenius inner) product of this and rhs: the sum of the products of corresponding elements.
+   * @param rhs - the Matrix object to take the dot product with; must be the same size as this.
+   * @return the dot product, or smallest possible value for long long if the sizes don't match.
+   */
+  long long dot( const Matrix &rhs ) const;
+
+  /**
+   * Returns the sum of each column (dim = 1) or of each row (dim = 2), in 64 bits like sum().
+   * @param dim - 1 to add up along the rows (per column), 2 to add up along the columns (per row)
+   * @return one sum per column or row, empty if dim isn't valid.
+   */
+  std::vector<long long> sums( unsigned int dim ) const;
+
+  /**
+   * Creates and returns the smallest element of each column (dim = 1, a 1-by-n matrix) or of each row (dim = 2, an m-by-1 matrix).
+   * @param dim - 1 per column, 2 per row
+   * @return a new Matrix object with the smallest elements, a 0-by-0 matrix if dim isn't valid.
+   */
+  const Matrix mins( unsigned int dim ) const;
+
+  /**
+   * Creates and returns the largest element of each column (dim = 1, a 1-by-n matrix) or of each row (dim = 2, an m-by-1 matrix).
+   * @param dim - 1 per column, 2 per row
+   * @return a new Matrix object with the largest elements, a 0-by-0 matrix if dim isn't valid.
+   */
+  const Matrix maxs( unsigned int dim ) const;
+
+  /**
+   * Returns where the smallest element of each column (dim = 1: its row) or of each row (dim = 2: its column) is; the first one if there are several.
+   * @param dim - 1 per column, 2 per row
+   * @return one index per column or row, empty if dim isn't valid.
+   */
+  std::vector<unsigned int> argmins( unsigned int dim ) const;
+
+  /**
+   * Returns where the largest element of each column (dim = 1: its row) or of each row (dim = 2: its column) is; the first one if there are several.
+   * @param dim - 1 per column, 2 per row
+   * @return one index per column or row, empty if dim isn't valid.
+   */
+  std::vector<unsigned int> argmaxs( unsigned int dim ) const;
+
+  /**
+   * Returns the dot product of each column of this with the same column of rhs (dim = 1), or of each row with the same row (dim = 2).
+   * @param rhs - the Matrix object to take the dot products with; must be the same size as this.
+   * @param dim - 1 per column, 2 per row
+   * @return one dot product per column or row, empty if dim isn't valid or the sizes don't match.
+   */
+  std::vector<long long> dots( const Matrix &rhs, unsigned int dim ) const;
+
+  /**
+   * Creates and returns this matrix with f applied to every element: result(i) = f(this(i)).
+   * f is inlined into one loop over the elements in memory order, so keep it cheap and independent of the order it's called in.
+   * @param f - function (or lambda) taking an int and returning an int
+   * @param threads - number of threads to use, 1 (the default) for the calling thread only, 0 for one per core if the matrix is big enough
+   * @return a new Matrix object the same size as this.
+   */
+  template<class F>
+  const Matrix map( F f, unsigned int threads = 1 ) const;
+
+  /**
+   * Creates and returns f applied to every pair of corresponding elements of this and rhs: result(i) = f(this(i), rhs(i)).
+   * @param rhs - the Matrix object to pair up with this; must be the same size as this.
+   * @param f - function (or lambda) taking two ints and returning an int
+   * @param threads - number of threads to use, 1 (the default) for the calling thread only, 0 for one per core if the matrices are big enough
+   * @return a new Matrix object the same size as this, a 0-by-0 matrix if the sizes don't match.
+   */
+  template<class F>
+  const Matrix zip( const Matrix &rhs, F f, unsigned int threads = 1 ) const;
+
+  /**
+   * Applies f to every element of this matrix in place: this(i) = f(this(i)).
+   * @param f - function (or lambda) taking an int and returning an int
+   * @param threads - number of threads to use, 1 (the default) for the calling thread only, 0 for one per core if the matrix is big enough
+   */
+  template<class F>
+  void transform( F f, unsigned int threads = 1 );
   
   /**
    * Outputs this Matrix object on the given ostream (for debugging).
@@ -124,9 +374,123 @@ public:
   void output( std::ostream &out ) const;
 
 private:
-  std::vector<int> A; //our matrix, stored column-wise
+  std::shared_ptr<std::vector<int> > A; //our matrix, stored column-wise; shared with copies until one of them writes
   unsigned int m; //number of rows
   unsigned int n; //number of columns
   //NOTE: m, n should be const but making them so complicates the constructors
+
+  /**
+   * Gives this object its own copy of the elements if they are shared with another Matrix; must be called before any write to A.
+   */
+  void detach();
+
+  /**
+   * Bareiss fraction-free elimination on the first rows columns of M (rows-by-cols, stored row by row), with row pivoting;
+   * every division is exact, and afterwards M(k, k) is the k-th leading principal minor of the row-permuted matrix.
+   * @param det - receives the determinant of the leading rows-by-rows block, 0 if it is singular (elimination then stops early).
+   * @return false if a value doesn't fit in 64 bits.
+   */
+  static bool bareiss( std::vector<long long> &M, unsigned int rows, unsigned int cols, long long &det );
+
+  /**
+   * Brings M (rows-by-cols, stored row by row, elements in [0, p)) to row-echelon form over Z_p on its first limit columns, pivots scaled to 1;
+   * with reduced, entries above the pivots are cleared too.  Pivots are found a panel of rows at a time, and each panel is taken out of the
+   * other rows as one matrix product; rows are only reduced mod p when they could overflow (or become pivot rows).
+   * @param pivots - receives the pivot column of each of the first rank rows.
+   * @param threads - number of threads to split the rows over.
+   * @return the rank of the first limit columns.
+   */
+  static unsigned int echelon( std::vector<unsigned int> &M, unsigned int rows, unsigned int cols, unsigned int limit, unsigned int p, bool reduced, std::vector<unsigned int> &pivots, unsigned int threads );
+
+  /**
+   * Copies this matrix row by row into M, with room for extra columns on the right, reduced mod p.
+   */
+  void rowsMod( std::vector<unsigned int> &M, unsigned int extra, unsigned int p ) const;
+
+  /**
+   * Returns true if p is a prime below 32768, so 4 * (p - 1)^2 plus p - 1 fits in 32 bits.
+   */
+  static bool prime( unsigned int p );
+
+  /**
+   * Returns an m-by-n matrix of zeros with its own elements, ready to be written through A->data().
+   */
+  static Matrix zeros( unsigned int m, unsigned int n );
+
+  /**
+   * Returns how many threads to give a job on this many elements: threads itself (at most one per element), or for 0 one per core
+   * if there are enough elements to be worth it.
+   */
+  static unsigned int pieces( std::size_t elements, unsigned int threads = 0 );
+
+  /**
+   * Splits [0, count) into the given number of contiguous pieces and runs work(piece, begin, end) on each, one thread per piece.
+   */
+  template<class Work>
+  static void parallel( std::size_t count, unsigned int pieces, Work work );
+
+  /**
+   * Returns where the smallest (less = true) or largest element of each column (dim = 1) or row (dim = 2) is, as for argmins/argmaxs.
+   */
+  std::vector<unsigned int> extremes( unsigned int dim, bool less ) const;
 };
+
+template<class Work>
+void Matrix::parallel( std::size_t count, unsigned int pieces, Work work )
+{
+  std::size_t per = ( count + pieces - 1 ) / pieces;
+  std::vector<std::thread> pool;
+  for ( unsigned int t = 1; t < pieces; t++ ) {
+    pool.push_back( std::thread( work, t, std::min( count, t * per ), std::min( count, ( t + 1 ) * per ) ) );
+  }
+  work( 0u, static_cast<std::size_t>( 0 ), std::min( count, per ) );
+  for ( std::size_t t = 0; t < pool.size(); t++ ) {
+    pool[t].join();
+  }
+}
+
+template<class F>
+const Matrix Matrix::map( F f, unsigned int threads ) const
+{
+  // a fresh buffer for the result, written straight through a pointer so the loop has no bounds checks and can be vectorised
+  Matrix result = zeros( m, n );
+  const int* in = A->data();
+  int* out = result.A->data();
+  parallel( A->size(), pieces( A->size(), threads ), [&]( unsigned int, std::size_t begin, std::size_t end ) {
+    for ( std::size_t i = begin; i < end; i++ ) {
+      out[i] = f( in[i] );
+    }
+  } );
+  return result;
+}
+
+template<class F>
+const Matrix Matrix::zip( const Matrix &rhs, F f, unsigned int threads ) const
+{
+  if ( m != rhs.m || n != rhs.n ) {
+    return Matrix( std::vector<int>(), 0, 0 );
+  }
+  Matrix result = zeros( m, n );
+  const int* a = A->data();
+  const int* b = rhs.A->data();
+  int* out = result.A->data();
+  parallel( A->size(), pieces( A->size(), threads ), [&]( unsigned int, std::size_t begin, std::size_t end ) {
+    for ( std::size_t i = begin; i < end; i++ ) {
+      out[i] = f( a[i], b[i] );
+    }
+  } );
+  return result;
+}
+
+template<class F>
+void Matrix::transform( F f, unsigned int threads )
+{
+  detach();
+  int* a = A->data();
+  parallel( A->size(), pieces( A->size(), threads ), [&]( unsigned int, std::size_t begin, std::size_t end ) {
+    for ( std::size_t i = begin; i < end; i++ ) {
+      a[i] = f( a[i] );
+    }
+  } );
+}
 #endif
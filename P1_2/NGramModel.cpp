@@ -0,0 +1,294 @@
+#include "NGramModel.hpp"
+#include "Alphabet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using alpha29::BAD;
+using alpha29::L2N;
+
+namespace {
+	//start of every model file, followed by the order (4 bytes) and 4 bytes of padding so the values are aligned
+	const char MAGIC[8] = { 'H', 'I', 'L', 'L', 'N', 'G', 'M', '1' };
+	const std::size_t HEADER = 16;
+
+	/*
+	* Returns 29^n
+	*/
+	unsigned int power(unsigned int n) {
+		unsigned int result = 1;
+		while (n-- > 0) {
+			result *= 29;
+		}
+		return result;
+	}
+}
+
+/**
+ * Default constructor. It should create an empty model (order 0) that scores everything as 0.
+ */
+NGramModel::NGramModel() : n(0), size(0), values(nullptr), mapping(nullptr), mappingLength(0) {
+}
+
+/**
+ * Destructor.  Releases the table (unmaps it if it was loaded from a file).
+ */
+NGramModel::~NGramModel() {
+	clear();
+}
+
+/*
+* Makes the model empty again, unmapping any loaded file
+*/
+void NGramModel::clear() {
+#if defined(_WIN32)
+	// files are read into table on Windows, so there is never anything to unmap
+#else
+	if (mapping != nullptr) {
+		munmap(mapping, mappingLength);
+	}
+#endif
+	mapping = nullptr;
+	mappingLength = 0;
+	table.clear();
+	values = nullptr;
+	n = 0;
+	size = 0;
+}
+
+/**
+ * Builds the model from the given corpus, replacing whatever it held.  Characters outside the alphabet are skipped and break up n-grams.
+ * @param corpus - sample text of the language to model.
+ * @param n - length of the n-grams to count, 1 to 4.
+ * @return true if the model was built, false if n is out of range.
+ */
+bool NGramModel::build(const std::string& corpus, unsigned int n) {
+	if (n == 0 || n > MAX_ORDER) {
+		return false;
+	}
+	clear();
+
+	// count every n-gram, keeping the index of the last n characters as a rolling base-29 number
+	unsigned int size = power(n);
+	std::vector<double> counts(size, 0);
+	unsigned int index = 0;
+	unsigned int run = 0;
+	double total = 0;
+	for (std::size_t i = 0; i < corpus.length(); i++) {
+		unsigned char value = L2N[static_cast<unsigned char>(corpus[i])];
+		if (value == BAD) {
+			run = 0;
+			continue;
+		}
+		index = (index * 29 + value) % size;
+		if (++run >= n) {
+			counts[index] += 1;
+			total += 1;
+		}
+	}
+
+	// log-probabilities times 100, with half a count for n-grams never seen so they aren't impossible
+	table.resize(size);
+	for (unsigned int i = 0; i < size; i++) {
+		double value = std::log((counts[i] + 0.5) / (total + 0.5 * size)) * 100;
+		table[i] = static_cast<short>(std::max(value, -32768.0));
+	}
+	values = table.data();
+	this->n = n;
+	this->size = size;
+	return true;
+}
+
+/**
+ * Writes the model to the given file, to be loaded later.
+ * @param path - file to write.
+ * @return true if the whole model was written.
+ */
+bool NGramModel::save(const std::string& path) const {
+	if (n == 0) {
+		return false;
+	}
+
+	std::ofstream out(path.c_str(), std::ios::binary);
+	char header[HEADER] = {};
+	std::memcpy(header, MAGIC, sizeof(MAGIC));
+	std::memcpy(header + sizeof(MAGIC), &n, sizeof(n));
+	out.write(header, HEADER);
+	out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(size * sizeof(short)));
+	return static_cast<bool>(out);
+}
+
+/**
+ * Loads a model written by save(), replacing whatever it held; the table is mapped into memory rather than read.
+ * @param path - file to load.
+ * @return true if the file held a valid model, false otherwise (the model is then empty).
+ */
+bool NGramModel::load(const std::string& path) {
+	clear();
+
+#if defined(_WIN32)
+	// no mmap here: read the file into table instead
+	std::ifstream in(path.c_str(), std::ios::binary);
+	std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	const char* data = file.data();
+	std::size_t length = file.size();
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	mapping = data;
+	mappingLength = static_cast<std::size_t>(info.st_size);
+	std::size_t length = mappingLength;
+#endif
+
+	// check the header and that the file holds exactly 29^n values
+	unsigned int order = 0;
+	if (length >= HEADER) {
+		std::memcpy(&order, static_cast<const char*>(data) + sizeof(MAGIC), sizeof(order));
+	}
+	if (length < HEADER || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || order == 0 || order > MAX_ORDER
+		|| length != HEADER + power(order) * sizeof(short)) {
+		clear();
+		return false;
+	}
+
+	n = order;
+	size = power(order);
+#if defined(_WIN32)
+	table.resize(size);
+	std::memcpy(table.data(), data + HEADER, size * sizeof(short));
+	values = table.data();
+#else
+	values = reinterpret_cast<const short*>(static_cast<const char*>(data) + HEADER);
+#endif
+	return true;
+}
+
+/**
+ * Returns the length of the n-grams in the model.
+ * @return n, 0 for an empty model.
+ */
+unsigned int NGramModel::order() const {
+	return n;
+}
+
+/**
+ * Returns the log-probability (times 100) of each single symbol, summed out of the model's n-grams (the n-grams starting with it).
+ * @return 29 values, indexed by symbol; empty for an empty model.
+ */
+std::vector<int> NGramModel::unigrams() const {
+	std::vector<int> result;
+	if (n == 0) {
+		return result;
+	}
+
+	// the n-grams starting with symbol a are one contiguous run of 29^(n-1) values
+	unsigned int run = size / 29;
+	for (unsigned int a = 0; a < 29; a++) {
+		double sum = 0;
+		for (unsigned int i = 0; i < run; i++) {
+			sum += std::exp(values[a * run + i] / 100.0);
+		}
+		result.push_back(static_cast<int>(std::max(std::log(sum) * 100, -32768.0)));
+	}
+	return result;
+}
+
+/**
+ * Scores a text given as numerical values (0-28): the sum of the log-probabilities (times 100) of all its n-grams.
+ * @param symbols - the text, one value per character.
+ * @param length - number of characters in symbols.
+ * @return the score; the higher, the more the text looks like the corpus.
+ */
+long NGramModel::score(const unsigned char* symbols, std::size_t length) const {
+	if (n == 0 || length < n) {
+		return 0;
+	}
+
+	// every n-gram's index is worked out on its own (no rolling index, so no division and no chain from one window to the next),
+	// a batch at a time: the index loop is plain arithmetic on neighbouring bytes, which the compiler vectorises, and the lookups
+	// that follow don't depend on each other, so the processor overlaps them
+	const std::size_t BATCH = 256;
+	unsigned int indices[BATCH];
+	std::size_t windows = length - n + 1;
+	long total = 0;
+	for (std::size_t begin = 0; begin < windows; begin += BATCH) {
+		std::size_t count = std::min(BATCH, windows - begin);
+		const unsigned char* s = symbols + begin;
+		switch (n) {
+		case 1:
+			for (std::size_t i = 0; i < count; i++) {
+				indices[i] = s[i];
+			}
+			break;
+		case 2:
+			for (std::size_t i = 0; i < count; i++) {
+				indices[i] = s[i] * 29u + s[i + 1];
+			}
+			break;
+		case 3:
+			for (std::size_t i = 0; i < count; i++) {
+				indices[i] = (s[i] * 29u + s[i + 1]) * 29u + s[i + 2];
+			}
+			break;
+		default:
+			for (std::size_t i = 0; i < count; i++) {
+				indices[i] = ((s[i] * 29u + s[i + 1]) * 29u + s[i + 2]) * 29u + s[i + 3];
+			}
+			break;
+		}
+		int sum0 = 0, sum1 = 0;
+		std::size_t i = 0;
+		for (; i + 2 <= count; i += 2) {
+			sum0 += values[indices[i]];
+			sum1 += values[indices[i + 1]];
+		}
+		if (i < count) {
+			sum0 += values[indices[i]];
+		}
+		total += static_cast<long>(sum0) + sum1;
+	}
+	return total;
+}
+
+/**
+ * Scores a text: the sum of the log-probabilities (times 100) of all its n-grams.  Characters outside the alphabet are skipped and break up n-grams.
+ * @param text - the text to score.
+ * @return the score; the higher, the more the text looks like the corpus.
+ */
+long NGramModel::score(const std::string& text) const {
+	long total = 0;
+	std::vector<unsigned char> run;
+	for (std::size_t i = 0; i <= text.length(); i++) {
+		unsigned char value = i < text.length() ? L2N[static_cast<unsigned char>(text[i])] : BAD;
+		if (value != BAD) {
+			run.push_back(value);
+		}
+		else {
+			total += score(run.data(), run.size());
+			run.clear();
+		}
+	}
+	return total;
+}
@@ -0,0 +1,93 @@
+#ifndef _NGRAMMODEL_HPP_
+#define _NGRAMMODEL_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * A C++ class to score how much a text over our 29 character alphabet looks like the language of a training corpus.
+ * It holds the log-probability of every n-gram (n = 1 to 4) as a flat array of 16 bit values indexed by the n-gram read as a base-29 number,
+ * so scoring a text is one table lookup per character.  Models are built once from a corpus, saved, and memory-mapped when loaded.
+ */
+class NGramModel
+{
+public:
+	/**
+	 * Default constructor. It should create an empty model (order 0) that scores everything as 0.
+	 */
+	NGramModel();
+
+	/**
+	 * Destructor.  Releases the table (unmaps it if it was loaded from a file).
+	 */
+	~NGramModel();
+
+	//a model owns its mapping, so it can't be copied
+	NGramModel(const NGramModel&) = delete;
+	NGramModel& operator=(const NGramModel&) = delete;
+
+	/**
+	 * Builds the model from the given corpus, replacing whatever it held.  Characters outside the alphabet are skipped and break up n-grams.
+	 * @param corpus - sample text of the language to model.
+	 * @param n - length of the n-grams to count, 1 to 4.
+	 * @return true if the model was built, false if n is out of range.
+	 */
+	bool build(const std::string& corpus, unsigned int n);
+
+	/**
+	 * Writes the model to the given file, to be loaded later.
+	 * @param path - file to write.
+	 * @return true if the whole model was written.
+	 */
+	bool save(const std::string& path) const;
+
+	/**
+	 * Loads a model written by save(), replacing whatever it held; the table is mapped into memory rather than read.
+	 * @param path - file to load.
+	 * @return true if the file held a valid model, false otherwise (the model is then empty).
+	 */
+	bool load(const std::string& path);
+
+	/**
+	 * Returns the length of the n-grams in the model.
+	 * @return n, 0 for an empty model.
+	 */
+	unsigned int order() const;
+
+	/**
+	 * Scores a text given as numerical values (0-28): the sum of the log-probabilities (times 100) of all its n-grams.
+	 * @param symbols - the text, one value per character.
+	 * @param length - number of characters in symbols.
+	 * @return the score; the higher, the more the text looks like the corpus.
+	 */
+	long score(const unsigned char* symbols, std::size_t length) const;
+
+	/**
+	 * Scores a text: the sum of the log-probabilities (times 100) of all its n-grams.  Characters outside the alphabet are skipped and break up n-grams.
+	 * @param text - the text to score.
+	 * @return the score; the higher, the more the text looks like the corpus.
+	 */
+	long score(const std::string& text) const;
+
+	/**
+	 * Returns the log-probability (times 100) of each single symbol, summed out of the model's n-grams (the n-grams starting with it).
+	 * @return 29 values, indexed by symbol; empty for an empty model.
+	 */
+	std::vector<int> unigrams() const;
+
+	//longest n-grams a model can hold (29^4 values take 1.4 MB)
+	static const unsigned int MAX_ORDER = 4;
+
+private:
+	unsigned int n; //length of the n-grams, 0 if empty
+	unsigned int size; //29^n, the number of values
+	std::vector<short> table; //the values when built in memory
+	const short* values; //the values in use: table's, or inside the mapped file
+	void* mapping; //the mapped file, if loaded
+	std::size_t mappingLength; //length of the mapped file
+
+	//Makes the model empty again, unmapping any loaded file
+	void clear();
+};
+#endif
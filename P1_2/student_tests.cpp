@@ -1,8 +1,32 @@
 #include "catch.hpp"
+#include "BasicHill.hpp"
 #include "Hill.hpp"
+#include "HillStream.hpp"
+#include "KeyGenerator.hpp"
 #include "Matrix.hpp"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <sstream>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
 using namespace std;
 
+namespace {
+	// size pseudo-random values in [lo, hi], from a linear congruential generator; the same seed always gives the same values
+	std::vector<int> randomValues(std::size_t size, unsigned int seed, int lo, int hi) {
+		std::vector<int> values(size);
+		unsigned int range = static_cast<unsigned int>(hi - lo) + 1;
+		for (std::size_t i = 0; i < size; i++) {
+			seed = seed * 1103515245 + 12345;
+			values[i] = lo + static_cast<int>((seed >> 8) % range);
+		}
+		return values;
+	}
+}
+
 TEST_CASE( "default constructor", "[Hill]" )
 {
   INFO("Hint: default constructor (linear getE/D() must work)");
@@ -38,17 +62,893 @@ TEST_CASE("parameterized const w/ 2 inputs", "[Hill]")
 
 
 TEST_CASE("encrypt", "[Hill]") {
+	Hill LS;
+	REQUIRE(LS.encrypt("MEET ME AT THE USUAL PLACE AT TEN.") == "HKHYF?FL I.E.TAJJ?E.ONWPQ ?ZGNVJRI");
 
+	// characters outside the alphabet, or text that doesn't fill whole blocks, can't be encrypted
+	REQUIRE(LS.encrypt("MEET ME AT THE USUAL PLACE AT TEN!") == "");
+	REQUIRE(LS.encrypt("ABC") == "");
 }
 
 TEST_CASE("encrypt 2.0", "[Hill]") {
+	Matrix A(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3);
+	Hill O(A, true);
 
+	// long enough to be split over several threads
+	std::string P;
+	for (int i = 0; i < 5000; i++) {
+		P += "ATTACK AT DAWN? NO.  ";
+	}
+
+	std::string C = O.encrypt(P);
+	REQUIRE(C.substr(0, 21) == "QGLKZOYIRJLRTNIRVRKRH");
+	REQUIRE(O.encryptParallel(P, 4) == C);
+	REQUIRE(O.decryptParallel(C, 3) == P);
+	REQUIRE(O.encryptParallel(P + "!!!", 4) == "");
 }
 
 TEST_CASE("decrypt", "[Hill]") {
-
+	Hill LS;
+	REQUIRE(LS.decrypt("HKHYF?FL I.E.TAJJ?E.ONWPQ ?ZGNVJRI") == "MEET ME AT THE USUAL PLACE AT TEN.");
+	REQUIRE(LS.privateN2let(Matrix(std::vector<int>{0, 25, 26, 27, 28, 7, 8, 28, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 18)) == "AZ.? HI BCDEFGHIJK");
 }
 
 TEST_CASE("decrypt 2.0", "[Hill]") {
+	Matrix A(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3);
+	Matrix B(std::vector<int>{2, 14, 14, 10, 13, 25, 18, 27, 2}, 3, 3);
+	Hill O;
+
+	// keys given per call, including one that needs reducing mod 29 first
+	REQUIRE(O.encrypt("ATTACK AT DAWN? NO.  ", A) == "QGLKZOYIRJLRTNIRVRKRH");
+	REQUIRE(O.decrypt("QGLKZOYIRJLRTNIRVRKRH", B) == "ATTACK AT DAWN? NO.  ");
+	REQUIRE(O.decrypt("QGLKZOYIRJLRTNIRVRKRH", B.add(B.mult(29))) == "ATTACK AT DAWN? NO.  ");
+
+	// setting a key switches both directions over
+	REQUIRE(O.setE(A));
+	REQUIRE(O.getD().equal(B));
+	REQUIRE(O.decrypt("QGLKZOYIRJLRTNIRVRKRH") == "ATTACK AT DAWN? NO.  ");
+	REQUIRE(O.setD(B));
+	REQUIRE(O.getE().equal(A));
+	REQUIRE(O.encrypt("ATTACK AT DAWN? NO.  ") == "QGLKZOYIRJLRTNIRVRKRH");
+}
+
+TEST_CASE("copies share until written", "[Matrix]")
+{
+	Matrix A(std::vector<int>{1, 2, 3, 4}, 2, 2);
+	Matrix B = A;
+	REQUIRE(B.equal(A));
+
+	// writing to the copy must not be seen by the original
+	REQUIRE(B.set(0, 0, 9));
+	REQUIRE(B.get(0, 0) == 9);
+	REQUIRE(A.get(0, 0) == 1);
+
+	Hill H;
+	Matrix E = H.getE();
+	E.set(0, 7);
+	REQUIRE(H.getE().get(0) == 2);
+}
+
+TEST_CASE("mult with a non-square right-hand side", "[Matrix]")
+{
+	Matrix A(std::vector<int>{1, 3, 2, 4}, 2, 2);
+	Matrix B(std::vector<int>{1, 1, 2, 0, 0, 3}, 2, 3);
+	Matrix C(std::vector<int>{3, 7, 2, 6, 6, 12}, 2, 3);
+	REQUIRE(A.mult(B).equal(C));
+}
+
+
+TEST_CASE("stream encrypt/decrypt", "[HillStream]")
+{
+	Hill LS;
+	std::string P = "MEET ME AT THE USUAL PLACE AT TEN.";
+
+	// pieces that split blocks in odd places
+	std::ostringstream out;
+	HillStream S(LS, true, out);
+	REQUIRE(S.write(P.substr(0, 3)));
+	REQUIRE(S.write(P.substr(3, 16)));
+	REQUIRE(S.write(P.substr(19)));
+	REQUIRE(S.finish());
+	REQUIRE(out.str() == LS.encrypt(P));
+
+	// whole istream through the callback
+	std::istringstream in(out.str());
+	std::string back;
+	HillStream R(LS, false, [&back](const char* s, std::size_t length) { back.append(s, length); });
+	REQUIRE(R.run(in));
+	REQUIRE(back == P);
+
+	// a partial block at the end can't be encrypted
+	std::ostringstream bad;
+	HillStream T(LS, true, bad);
+	REQUIRE(T.write("ABC"));
+	REQUIRE_FALSE(T.finish());
+}
+
+TEST_CASE("2x2 table covers every block", "[Hill]")
+{
+	const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ.? ";
+	Matrix E(std::vector<int>{2, 4, 3, 5}, 2, 2);
+	Hill LS(E, true);
+
+	// every possible block once, checked against the matrix arithmetic
+	std::string P, C;
+	for (int a = 0; a < 29; a++) {
+		for (int b = 0; b < 29; b++) {
+			P += alphabet[a];
+			P += alphabet[b];
+			Matrix c = E.mult(Matrix(std::vector<int>{a, b}, 2, 1));
+			C += alphabet[c.get(0) % 29];
+			C += alphabet[c.get(1) % 29];
+		}
+	}
+	REQUIRE(LS.encrypt(P) == C);
+	REQUIRE(LS.decrypt(C) == P);
+}
+
+TEST_CASE("large keys agree with the matrix arithmetic", "[Hill]")
+{
+	const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ.? ";
+	Hill LS;
+
+	// 16-by-16 goes through the column tables, 17-by-17 through the plain kernel
+	for (unsigned int n = 15; n <= 17; n++) {
+		std::vector<int> k(n * n), p(3 * n);
+		for (unsigned int i = 0; i < k.size(); i++) {
+			k[i] = (i * 7 + 3) % 31 - 1;
+		}
+		std::string P;
+		for (unsigned int i = 0; i < p.size(); i++) {
+			p[i] = (i * 5 + 1) % 29;
+			P += alphabet[p[i]];
+		}
+
+		Matrix K(k, n, n);
+		Matrix c = K.mult(Matrix(p, n, 3));
+		std::string C;
+		for (unsigned int i = 0; i < 3 * n; i++) {
+			C += alphabet[(c.get(i) % 29 + 29) % 29];
+		}
+		REQUIRE(LS.encrypt(P, K) == C);
+	}
+}
+
+TEST_CASE("batch encrypt/decrypt", "[Hill]")
+{
+	Hill LS;
+	std::vector<std::string> P = { "MEET ME AT THE USUAL PLACE AT TEN.", "", "ODD", "HI", "NO!!", "BYE." };
+	std::string arena;
+	std::vector<std::size_t> offsets;
+
+	// the odd-length and the bad-character messages come back empty
+	REQUIRE(LS.encryptBatch(P.data(), P.size(), arena, offsets) == 4);
+	REQUIRE(offsets.size() == P.size() + 1);
+	for (std::size_t i = 0; i < P.size(); i++) {
+		REQUIRE(arena.substr(offsets[i], offsets[i + 1] - offsets[i]) == LS.encrypt(P[i]));
+	}
+
+	std::vector<std::string> C = { LS.encrypt(P[0]), LS.encrypt(P[3]), LS.encrypt(P[5]) };
+	REQUIRE(LS.decryptBatch(C.data(), C.size(), arena, offsets) == 3);
+	REQUIRE(arena == P[0] + P[3] + P[5]);
+}
+
+TEST_CASE("one text under many keys", "[Hill]")
+{
+	Hill LS;
+	std::vector<Matrix> keys = {
+		Matrix(std::vector<int>{2, 4, 3, 5}, 2, 2),
+		Matrix(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3),
+		Matrix(std::vector<int>{1, 2, 3}, 3),
+		Matrix(std::vector<int>{12, 2, 16, 28}, 2, 2),
+	};
+	std::string P = "ATTACK AT DAWN? NO.   ";
+	std::string Q = "ATTACK AT DAWN? NO.  ";
+
+	std::vector<std::string> C = LS.cipherMany(P, keys);
+	REQUIRE(C.size() == keys.size());
+	for (std::size_t i = 0; i < keys.size(); i++) {
+		REQUIRE(C[i] == LS.encrypt(P, keys[i]));
+	}
+	REQUIRE(C[1] == "");
+
+	// the same call decrypts when given decryption keys
+	std::vector<std::string> D = LS.cipherMany(Q, keys);
+	REQUIRE(D[1] == LS.decrypt(Q, keys[1]));
+	REQUIRE(D[0] == "");
+}
+
+TEST_CASE("encrypt/decrypt into caller buffers", "[Hill]")
+{
+	Hill LS;
+	const char P[] = "MEET ME AT THE USUAL PLACE AT TEN.";
+	char out[64];
+
+	REQUIRE(LS.encrypt(P, 34, out, sizeof(out)) == 34);
+	REQUIRE(std::string(out, 34) == "HKHYF?FL I.E.TAJJ?E.ONWPQ ?ZGNVJRI");
+
+	// in place
+	REQUIRE(LS.decrypt(out, 34, out, 34) == 34);
+	REQUIRE(std::string(out, 34) == P);
+
+	// too little room, half a block, or a bad character
+	REQUIRE(LS.encrypt(P, 34, out, 33) == 0);
+	REQUIRE(LS.encrypt(P, 33, out, sizeof(out)) == 0);
+	REQUIRE(LS.encrypt("HI!!", 4, out, sizeof(out)) == 0);
+}
+
+TEST_CASE("key inversion", "[Hill]")
+{
+	// needs a row swap: the first pivot is 0
+	Hill S(Matrix(std::vector<int>{0, 1, 1, 0}, 2, 2), true);
+	REQUIRE(S.getD().equal(Matrix(std::vector<int>{0, 1, 1, 0}, 2, 2)));
+
+	// negative and unreduced entries
+	Hill N(Matrix(std::vector<int>{-27, 33, 61, -24}, 2, 2), true);
+	REQUIRE(N.getD().equal(Matrix(std::vector<int>{12, 2, 16, 28}, 2, 2)));
+
+	// singular mod 29
+	Hill Z(Matrix(std::vector<int>{1, 2, 2, 4}, 2, 2), true);
+	REQUIRE(Z.getE().size(1) == 0);
+	REQUIRE(Z.getD().size(1) == 0);
+
+	// a large key: E * D has to come out as the identity mod 29
+	unsigned int n = 64;
+	Hill L(Matrix(randomValues(n * n, 12345, 0, 28), n, n), true);
+	REQUIRE(L.getD().size(1) == n);
+	Matrix I = L.getE().mult(L.getD());
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int j = 0; j < n; j++) {
+			REQUIRE(I.get(i, j) % 29 == (i == j ? 1 : 0));
+		}
+	}
+}
+
+TEST_CASE("determinant mod 29", "[Hill]")
+{
+	Hill LS;
+	REQUIRE(LS.privateDetMod(Matrix(std::vector<int>{2, 4, 3, 5}, 2, 2)) == 27);
+	REQUIRE(LS.privateDetMod(Matrix(std::vector<int>{0, 1, 1, 0}, 2, 2)) == 28);
+	REQUIRE(LS.privateDetMod(Matrix(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3)) == 5);
+	REQUIRE(LS.privateDetMod(Matrix(std::vector<int>{1, 2, 2, 4}, 2, 2)) == 0);
+	REQUIRE(LS.privateDetMod(Matrix(std::vector<int>{1, 2, 3}, 3)) == -1);
+
+	// keys that fail the determinant check are turned down (and leave no key set)
+	REQUIRE_FALSE(LS.setE(Matrix(std::vector<int>{1, 2, 2, 4}, 2, 2)));
+	REQUIRE(LS.getE().size(1) == 0);
+	REQUIRE(LS.setD(Matrix(std::vector<int>{12, 2, 16, 28}, 2, 2)));
+	REQUIRE(LS.getE().equal(Matrix(std::vector<int>{2, 4, 3, 5}, 2, 2)));
+}
+
+TEST_CASE("other alphabets", "[BasicHill]")
+{
+	// the 29 character instance agrees with Hill
+	Matrix A(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3);
+	BasicHill<Alpha29> H(A, true);
+	REQUIRE(H.getD().equal(Matrix(std::vector<int>{2, 14, 14, 10, 13, 25, 18, 27, 2}, 3, 3)));
+	REQUIRE(H.encrypt("ATTACK AT DAWN? NO.  ") == "QGLKZOYIRJLRTNIRVRKRH");
+
+	// the textbook example over 26 letters: {{3, 3}, {2, 5}} has the inverse {{15, 17}, {20, 9}}
+	Hill26 L(Matrix(std::vector<int>{3, 2, 3, 5}, 2, 2), true);
+	REQUIRE(L.getD().equal(Matrix(std::vector<int>{15, 20, 17, 9}, 2, 2)));
+	REQUIRE(L.encrypt("HELP") == "HIAT");
+	REQUIRE(L.decrypt("HIAT") == "HELP");
+	REQUIRE(L.encrypt("HELP ") == "");
+	// an even determinant can't be inverted mod 26 even though it can mod 13
+	REQUIRE_FALSE(L.setE(Matrix(std::vector<int>{2, 2, 1, 3}, 2, 2)));
+	REQUIRE(L.getE().size(1) == 0);
+
+	// 95 = 5 * 19, and any printable text
+	Hill95 Q;
+	REQUIRE(Q.encrypt("hi") == "");
+	REQUIRE(Q.setD(Matrix(std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 10}, 3, 3)));
+	std::string text = "Hello, World! {x = 42}";
+	text += std::string((3 - text.length() % 3) % 3, '~');
+	REQUIRE(Q.decrypt(Q.encrypt(text)) == text);
+	REQUIRE(Q.getD().equal(Matrix(std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 10}, 3, 3)));
+
+	// 256 = 2^8: a fixed 8-by-8 key (column by column) with determinant 249 mod 256, which is odd so the key can be inverted, on binary data
+	Matrix K(std::vector<int>{
+		108, 78, 116, 146, 19, 37, 34, 46,
+		49, 161, 205, 19, 190, 18, 237, 66,
+		105, 102, 206, 36, 252, 35, 215, 219,
+		141, 32, 151, 97, 106, 6, 149, 110,
+		194, 138, 212, 3, 19, 104, 40, 212,
+		87, 30, 60, 93, 238, 110, 94, 192,
+		74, 145, 17, 95, 93, 59, 81, 62,
+		194, 83, 164, 22, 173, 110, 229, 56 }, 8, 8);
+	long long det = 0;
+	REQUIRE(K.det(det));
+	REQUIRE((det % 256 + 256) % 256 == 249);
+	Hill256 B;
+	REQUIRE(B.setE(K));
+	Matrix I = B.getE().mult(B.getD());
+	for (unsigned int i = 0; i < 8; i++) {
+		for (unsigned int j = 0; j < 8; j++) {
+			REQUIRE(I.get(i, j) % 256 == (i == j ? 1 : 0));
+		}
+	}
+	std::string data(4096, '\0');
+	for (std::size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<char>(i * 31 % 256);
+	}
+	std::string sealed = B.encrypt(data);
+	REQUIRE(sealed.size() == data.size());
+	REQUIRE(sealed != data);
+	REQUIRE(B.decrypt(sealed) == data);
+}
+
+TEST_CASE("key inverse cache", "[Hill]")
+{
+	Matrix A(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3);
+	Matrix B(std::vector<int>{2, 14, 14, 10, 13, 25, 18, 27, 2}, 3, 3);
+	Matrix K(std::vector<int>{5, 3, 2, 6}, 2, 2);
+	std::size_t capacity = Hill::inverseCacheCapacity();
+	Hill::setInverseCacheCapacity(1);
 
-}
\ No newline at end of file
+	// the second setup of the same key is a hit and gives the same inverse
+	Hill X(A, true);
+	std::size_t hits = Hill::inverseCacheHits();
+	std::size_t misses = Hill::inverseCacheMisses();
+	Hill Y(A, true);
+	REQUIRE(Hill::inverseCacheHits() == hits + 1);
+	REQUIRE(Hill::inverseCacheMisses() == misses);
+	REQUIRE(Y.getD().equal(B));
+	REQUIRE(Y.setD(A));
+	REQUIRE(Y.getE().equal(B));
+
+	// with room for one key only, another key pushes A out
+	Hill Z(K, true);
+	misses = Hill::inverseCacheMisses();
+	Hill W(A, true);
+	REQUIRE(Hill::inverseCacheMisses() == misses + 1);
+	REQUIRE(W.getD().equal(B));
+
+	// keys that can't be inverted are never cached
+	Hill::setInverseCacheCapacity(capacity);
+	REQUIRE(Hill::inverseCacheCapacity() == capacity);
+	Hill S(Matrix(std::vector<int>{1, 2, 2, 4}, 2, 2), true);
+	hits = Hill::inverseCacheHits();
+	Hill T(Matrix(std::vector<int>{1, 2, 2, 4}, 2, 2), true);
+	REQUIRE(Hill::inverseCacheHits() == hits);
+	REQUIRE(T.getE().size(1) == 0);
+}
+
+TEST_CASE("random keys", "[KeyGenerator]")
+{
+	KeyGenerator G(2024);
+	Matrix E, D;
+	REQUIRE_FALSE(G.next(1, E, D));
+	REQUIRE_FALSE(G.next(KeyGenerator::MAX_KEY + 1, E, D));
+
+	// every key is invertible and comes with its inverse, up to 64-by-64
+	for (unsigned int n = 2; n <= KeyGenerator::MAX_KEY; n += n < 8 ? 1 : 28) {
+		REQUIRE(G.next(n, E, D));
+		Hill LS(E, D);
+		REQUIRE(LS.getE().equal(E));
+		REQUIRE(LS.getD().equal(D));
+	}
+
+	// a batch is the same keys as one by one, whatever the number of threads
+	KeyGenerator A(7), B(7), C(7);
+	std::vector<Matrix> Es, Ds, Et, Dt;
+	REQUIRE(A.fill(16, 40, Es, Ds, 1) == 40);
+	REQUIRE(B.fill(16, 40, Et, Dt, 4) == 40);
+	for (std::size_t i = 0; i < 40; i++) {
+		REQUIRE(C.next(16, E, D));
+		REQUIRE(Es[i].equal(E));
+		REQUIRE(Et[i].equal(E));
+		REQUIRE(Dt[i].equal(D));
+	}
+	REQUIRE_FALSE(Es[0].equal(Es[1]));
+	REQUIRE(A.fill(0, 3, Es, Ds) == 0);
+
+	// keys are uniform over the invertible matrices: 28 * 812 of the 840 * 812 invertible 2-by-2 keys, 1 in 30, have a 0 in the top
+	// left corner (a triangular-factor key P * L * U would give about 1 in 60), so about 1000 of 30000, give or take 31
+	KeyGenerator U(99);
+	REQUIRE(U.fill(2, 30000, Es, Ds) == 30000);
+	int zeros = 0;
+	for (std::size_t i = 0; i < Es.size(); i++) {
+		zeros += Es[i].get(0, 0) == 0 ? 1 : 0;
+	}
+	REQUIRE(zeros > 850);
+	REQUIRE(zeros < 1150);
+}
+
+TEST_CASE("exact determinant, solve and inverse", "[Matrix]")
+{
+	long long d = 0;
+	REQUIRE(Matrix(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3).det(d));
+	REQUIRE(d == -198);
+	REQUIRE(Matrix(std::vector<int>{1, 2, 2, 4}, 2, 2).det(d));
+	REQUIRE(d == 0);
+	REQUIRE_FALSE(Matrix(std::vector<int>{1, 2, 3, 4, 5, 6}, 2, 3).det(d));
+
+	// a zero in the corner needs a row swap
+	REQUIRE(Matrix(std::vector<int>{0, 1, 1, 0}, 2, 2).det(d));
+	REQUIRE(d == -1);
+
+	// agrees with the determinant mod 29 on a bigger matrix, where cofactor expansion would take forever
+	std::vector<int> values = randomValues(20 * 20, 11, -3, 3);
+	Matrix big(values, 20, 20);
+	REQUIRE(big.det(d));
+	Hill LS;
+	REQUIRE(((d % 29) + 29) % 29 == LS.privateDetMod(big));
+
+	// {{4, 7}, {2, 6}}^-1 = {{6, -7}, {-2, 4}} / 10 and {{2, 1}, {1, 1}}^-1 = {{1, -1}, {-1, 2}}
+	Matrix num;
+	long long den = 0;
+	REQUIRE(Matrix(std::vector<int>{4, 2, 7, 6}, 2, 2).inverse(num, den));
+	REQUIRE(num.equal(Matrix(std::vector<int>{6, -2, -7, 4}, 2, 2)));
+	REQUIRE(den == 10);
+	REQUIRE(Matrix(std::vector<int>{2, 1, 1, 1}, 2, 2).inverse(num, den));
+	REQUIRE(num.equal(Matrix(std::vector<int>{1, -1, -1, 2}, 2, 2)));
+	REQUIRE(den == 1);
+	REQUIRE_FALSE(Matrix(std::vector<int>{1, 2, 2, 4}, 2, 2).inverse(num, den));
+
+	// big * X = B, checked by multiplying back
+	std::vector<int> rhs(20 * 2);
+	for (std::size_t i = 0; i < rhs.size(); i++) {
+		rhs[i] = static_cast<int>(i % 5) - 2;
+	}
+	Matrix B(rhs, 20, 2);
+	std::vector<int> small(5 * 5);
+	for (std::size_t i = 0; i < small.size(); i++) {
+		small[i] = values[i];
+	}
+	Matrix S(small, 5, 5);
+	Matrix b(std::vector<int>(rhs.begin(), rhs.begin() + 10), 5, 2);
+	REQUIRE(S.solve(b, num, den));
+	REQUIRE(den > 0);
+	REQUIRE(S.mult(num).equal(b.mult(static_cast<int>(den))));
+	REQUIRE_FALSE(S.solve(B, num, den));
+}
+
+TEST_CASE("echelon form, rank, nullspace and solve mod p", "[Matrix]")
+{
+	// rref of [A | I] is [I | A^-1]
+	Matrix AI(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10, 1, 0, 0, 0, 1, 0, 0, 0, 1}, 3, 6);
+	Matrix R = AI.rref(29);
+	REQUIRE(R.equal(Matrix(std::vector<int>{1, 0, 0, 0, 1, 0, 0, 0, 1, 2, 14, 14, 10, 13, 25, 18, 27, 2}, 3, 6)));
+	unsigned int r = 0;
+	REQUIRE(AI.rank(29, r));
+	REQUIRE(r == 3);
+	REQUIRE(AI.rref(28).size(1) == 0);
+	REQUIRE_FALSE(AI.rank(32771, r));
+
+	// a 60-by-40 product of 60-by-25 and 25-by-40 random matrices has rank 25, and a nullspace of 15 vectors
+	for (unsigned int p : { 2u, 29u, 32749u }) {
+		int half = static_cast<int>(p / 2);
+		Matrix F(randomValues(60 * 25, p, -half, static_cast<int>(p) - 1 - half), 60, 25);
+		Matrix G(randomValues(25 * 40, p + 1, 0, static_cast<int>(p) - 1), 25, 40);
+		// products can get too big for an int, so multiply mod p
+		std::vector<int> c(60 * 40);
+		for (unsigned int i = 0; i < 60; i++) {
+			for (unsigned int j = 0; j < 40; j++) {
+				long long sum = 0;
+				for (unsigned int k = 0; k < 25; k++) {
+					sum += static_cast<long long>(F.get(i, k)) * G.get(k, j) % p;
+				}
+				c[j * 60 + i] = static_cast<int>((sum % p + p) % p);
+			}
+		}
+		Matrix C(c, 60, 40);
+		REQUIRE(C.rank(p, r));
+		// over GF(2) a random 25-by-25 block may be singular; the bound always holds
+		REQUIRE(r <= 25);
+		if (p != 2) {
+			REQUIRE(r == 25);
+		}
+		Matrix N = C.nullspace(p);
+		REQUIRE(N.size(1) == 40);
+		REQUIRE(N.size(2) == 40 - r);
+		for (unsigned int i = 0; i < 60; i++) {
+			for (unsigned int j = 0; j < N.size(2); j++) {
+				long long sum = 0;
+				for (unsigned int k = 0; k < 40; k++) {
+					sum += static_cast<long long>(C.get(i, k)) * N.get(k, j) % p;
+				}
+				REQUIRE(sum % p == 0);
+			}
+		}
+
+		// y is the first column of C, so C * X = y has a solution (the first unit vector among others); a right-hand side outside the column space doesn't
+		std::vector<int> y(60);
+		for (unsigned int i = 0; i < 60; i++) {
+			y[i] = C.get(i, 0);
+		}
+		Matrix X;
+		REQUIRE(C.solve(Matrix(y, 60, 1), p, X));
+		for (unsigned int i = 0; i < 60; i++) {
+			long long sum = 0;
+			for (unsigned int k = 0; k < 40; k++) {
+				sum += static_cast<long long>(C.get(i, k)) * X.get(k, 0) % p;
+			}
+			REQUIRE(sum % p == static_cast<long long>(y[i]));
+		}
+		if (p != 2) {
+			y[0] = (y[0] + 1) % static_cast<int>(p);
+			REQUIRE_FALSE(C.solve(Matrix(y, 60, 1), p, X));
+		}
+	}
+
+	// rows are taken a panel of 64 at a time, and each panel out of the other rows as a product split over threads, which must not change
+	// the result; 100 rows and a rank of 90 make two panels in both the forward and the reduced phase
+	Matrix D(randomValues(100 * 90, 7, 0, 28), 100, 90);
+	unsigned int serial = 0;
+	REQUIRE(D.rank(29, serial));
+	REQUIRE(serial == 90);
+	for (unsigned int threads : { 2u, 3u, 0u }) {
+		REQUIRE(D.rank(29, r, threads));
+		REQUIRE(r == serial);
+		REQUIRE(D.rref(29, threads).equal(D.rref(29)));
+	}
+
+	// every third row is the sum of the two above it, so the pivot rows have to be moved up past the others; the nullspace and the
+	// solution are the same on any number of threads
+	std::vector<int> e = randomValues(150 * 130, 13, 0, 28);
+	for (unsigned int j = 0; j < 130; j++) {
+		for (unsigned int i = 2; i < 150; i += 3) {
+			e[j * 150 + i] = e[j * 150 + i - 1] + e[j * 150 + i - 2];
+		}
+	}
+	Matrix E(e, 150, 130);
+	REQUIRE(E.rank(29, r));
+	REQUIRE(r == 100);
+	Matrix N = E.nullspace(29);
+	REQUIRE(N.size(2) == 30);
+	Matrix EN = E.mult(N);
+	for (unsigned int i = 0; i < 150; i++) {
+		for (unsigned int j = 0; j < 30; j++) {
+			REQUIRE(EN.get(i, j) % 29 == 0);
+		}
+	}
+	std::vector<int> z(150);
+	for (unsigned int i = 0; i < 150; i++) {
+		z[i] = E.get(i, 0) + 2 * E.get(i, 1);
+	}
+	Matrix X;
+	REQUIRE(E.solve(Matrix(z, 150, 1), 29, X));
+	Matrix EX = E.mult(X);
+	for (unsigned int i = 0; i < 150; i++) {
+		REQUIRE((EX.get(i, 0) - z[i]) % 29 == 0);
+	}
+	for (unsigned int threads : { 2u, 3u, 0u }) {
+		REQUIRE(E.nullspace(29, threads).equal(N));
+		Matrix Y;
+		REQUIRE(E.solve(Matrix(z, 150, 1), 29, Y, threads));
+		REQUIRE(Y.equal(X));
+	}
+}
+
+TEST_CASE("reductions", "[Matrix]")
+{
+	// 2-by-3, column-wise {1, -4, 7, 2, -3, 7}
+	Matrix A(std::vector<int>{1, -4, 7, 2, -3, 7}, 2, 3);
+	REQUIRE(A.sum() == 10);
+	REQUIRE(A.min() == -4);
+	REQUIRE(A.max() == 7);
+	REQUIRE(A.argmin() == 1);
+	REQUIRE(A.argmax() == 2);
+	REQUIRE(A.trace() == 3);
+	REQUIRE(A.norm1() == 10);
+	REQUIRE(A.normInf() == 13);
+	REQUIRE(A.dot(A) == 128);
+	REQUIRE(A.dot(Matrix(std::vector<int>{1, 2, 3, 4, 5, 6}, 3, 2)) == LLONG_MIN);
+	REQUIRE(A.sums(1) == std::vector<long long>{-3, 9, 4});
+	REQUIRE(A.sums(2) == std::vector<long long>{5, 5});
+	REQUIRE(A.mins(1).equal(Matrix(std::vector<int>{-4, 2, -3}, 1, 3)));
+	REQUIRE(A.maxs(2).equal(Matrix(std::vector<int>{7, 7}, 2, 1)));
+	REQUIRE(A.argmins(2) == std::vector<unsigned int>{2, 0});
+	REQUIRE(A.argmaxs(1) == std::vector<unsigned int>{0, 0, 1});
+	REQUIRE(A.argmaxs(2) == std::vector<unsigned int>{1, 2});
+	REQUIRE(A.dots(A, 2) == std::vector<long long>{59, 69});
+	REQUIRE(A.sums(3).empty());
+	REQUIRE(A.argmins(0).empty());
+
+	// sums are 64-bit, so they don't wrap when they leave the int range
+	Matrix H(std::vector<int>{INT_MAX, INT_MAX, INT_MIN, INT_MIN}, 2, 2);
+	REQUIRE(H.sums(1) == std::vector<long long>{2LL * INT_MAX, 2LL * INT_MIN});
+	REQUIRE(H.sums(2) == std::vector<long long>{-1, -1});
+
+	Matrix E(std::vector<int>{}, 0, 0);
+	REQUIRE(E.sum() == 0);
+	REQUIRE(E.min() == INT_MIN);
+	REQUIRE(E.argmax() == 0);
+	REQUIRE(E.norm1() == 0);
+	REQUIRE(E.normInf() == 0);
+
+	// big enough to be split between threads; compare with plain loops
+	const unsigned int m = 1000, n = 700;
+	std::vector<int> a = randomValues(m * n, 7, -1000000, 1000000);
+	Matrix B(a, m, n);
+	long long sum = 0, rowMax = 0;
+	std::size_t low = 0;
+	for (std::size_t i = 0; i < a.size(); i++) {
+		sum += a[i];
+		low = a[i] < a[low] ? i : low;
+	}
+	for (unsigned int i = 0; i < m; i++) {
+		long long row = 0;
+		for (unsigned int j = 0; j < n; j++) {
+			row += std::llabs(a[j * m + i]);
+		}
+		rowMax = std::max(rowMax, row);
+	}
+	REQUIRE(B.sum() == sum);
+	REQUIRE(B.argmin() == low);
+	REQUIRE(B.min() == a[low]);
+	REQUIRE(B.normInf() == rowMax);
+	std::vector<long long> rows = B.sums(2);
+	REQUIRE(std::accumulate(rows.begin(), rows.end(), 0LL) == sum);
+	REQUIRE(B.mins(1).min() == a[low]);
+	REQUIRE(B.argmins(2)[low % m] == low / m);
+}
+
+TEST_CASE("map, zip and transform", "[Matrix]")
+{
+	Matrix A(std::vector<int>{-30, -1, 0, 28, 29, 58}, 2, 3);
+	Matrix B = A.map([](int x) { return (x % 29 + 29) % 29; });
+	REQUIRE(B.equal(Matrix(std::vector<int>{28, 28, 0, 28, 0, 0}, 2, 3)));
+	REQUIRE(A.get(0) == -30);
+	REQUIRE(A.zip(B, [](int x, int y) { return x - y; }).equal(Matrix(std::vector<int>{-58, -29, 0, 0, 29, 58}, 2, 3)));
+	REQUIRE(A.zip(Matrix(), [](int x, int y) { return x + y; }).size(1) == 0);
+
+	// a copy shares its elements until one of them is transformed
+	Matrix C = A;
+	C.transform([](int x) { return 2 * x; });
+	REQUIRE(C.equal(A.mult(2)));
+	REQUIRE(A.get(0) == -30);
+
+	// the same result on any number of threads
+	std::vector<int> a(1 << 20);
+	for (std::size_t i = 0; i < a.size(); i++) {
+		a[i] = static_cast<int>(i * 2654435761u % 1000003) - 500000;
+	}
+	Matrix L(a, 1024, 1024);
+	auto square = [](int x) { return x % 1000 * (x % 1000); };
+	Matrix one = L.map(square);
+	REQUIRE(L.map(square, 0).equal(one));
+	REQUIRE(L.map(square, 3).equal(one));
+	REQUIRE(L.zip(one, [](int x, int y) { return x ^ y; }, 4).equal(L.zip(one, [](int x, int y) { return x ^ y; })));
+	Matrix M = L;
+	M.transform(square, 5);
+	REQUIRE(M.equal(one));
+}
+
+TEST_CASE("Kronecker, Hadamard and block-diagonal products", "[Matrix]")
+{
+	Matrix A(std::vector<int>{1, 3, 2, 4}, 2, 2);
+	Matrix B(std::vector<int>{0, 5, 6, 1, -1, 2}, 2, 3);
+	// A = [1 2; 3 4], B = [0 6 -1; 5 1 2]
+	Matrix K = A.kron(B);
+	REQUIRE(K.size(1) == 4);
+	REQUIRE(K.size(2) == 6);
+	for (unsigned int i = 0; i < 4; i++) {
+		for (unsigned int j = 0; j < 6; j++) {
+			REQUIRE(K.get(i, j) == A.get(i / 2, j / 3) * B.get(i % 2, j % 3));
+		}
+	}
+	REQUIRE(A.hadamard(A).equal(Matrix(std::vector<int>{1, 9, 4, 16}, 2, 2)));
+	REQUIRE(A.hadamard(B).size(1) == 0);
+
+	// products that don't fit wrap around as in mult: (2^20)^2 is 2^40, 0 mod 2^32, and (2^16 + 1)^2 is 2^32 + 2^17 + 1
+	Matrix W(std::vector<int>{1 << 20, 65537}, 1, 2);
+	REQUIRE(W.hadamard(W).equal(Matrix(std::vector<int>{0, 131073}, 1, 2)));
+	REQUIRE(W.kron(W).equal(Matrix(std::vector<int>{0, 1 << 20, 1 << 20, 131073}, 1, 4)));
+
+	Matrix D = Matrix::blockDiag({ A, B, Matrix(std::vector<int>{7}, 1, 1) });
+	REQUIRE(D.equal(Matrix(std::vector<int>{
+		1, 3, 0, 0, 0, 2, 4, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0, 6, 1, 0, 0, 0, -1, 2, 0, 0, 0, 0, 0, 7 }, 5, 6)));
+	REQUIRE(Matrix::blockDiag({}).size(1) == 0);
+
+	// (A kron B) x without the product agrees with the product, on one thread and split over three
+	for (unsigned int size : { 3u, 40u }) {
+		Matrix P(randomValues(size * (size + 1), size, -9, 9), size + 1, size);
+		Matrix Q(randomValues(size * size, size + 1, -9, 9), size, size);
+		Matrix X(randomValues(size * size * 3, size + 2, -9, 9), size * size, 3), Y;
+		for (unsigned int threads : { 1u, 3u }) {
+			REQUIRE(P.kronMult(Q, X, Y, threads));
+			REQUIRE(Y.equal(P.kron(Q).mult(X)));
+		}
+		REQUIRE_FALSE(P.kronMult(Q, Q, Y));
+	}
+
+	// a product that doesn't fit in an int is reported, whether or not the sums on the way fit in 64 bits
+	Matrix Y;
+	Matrix big(std::vector<int>{1 << 20}, 1, 1);
+	REQUIRE_FALSE(big.kronMult(big, big, Y));
+	Matrix huge(std::vector<int>{INT_MAX, INT_MAX}, 1, 2), opposite(std::vector<int>{INT_MAX, -INT_MAX}, 2, 1);
+	REQUIRE(huge.kronMult(Matrix(std::vector<int>{2}, 1, 1), opposite, Y));
+	REQUIRE(Y.equal(Matrix(std::vector<int>{0}, 1, 1)));
+	REQUIRE_FALSE(huge.kronMult(huge, Matrix(std::vector<int>{INT_MAX, INT_MAX, INT_MAX, INT_MAX}, 4, 1), Y));
+}
+
+TEST_CASE("transposed products", "[Matrix]")
+{
+	// A = [1 2 3; 4 5 6], B = [1 0; 2 -1; 0 3]
+	Matrix A(std::vector<int>{1, 4, 2, 5, 3, 6}, 2, 3);
+	Matrix B(std::vector<int>{1, 2, 0, 0, -1, 3}, 3, 2);
+	REQUIRE(A.trans().equal(Matrix(std::vector<int>{1, 2, 3, 4, 5, 6}, 3, 2)));
+	REQUIRE(A.mult(B).equal(Matrix(std::vector<int>{5, 14, 7, 13}, 2, 2)));
+	REQUIRE(B.mult(A, true, true).equal(A.mult(B).trans()));
+	REQUIRE(A.mult(A, true, false).equal(A.trans().mult(A)));
+	REQUIRE(A.mult(A, false, true).equal(Matrix(std::vector<int>{14, 32, 32, 77}, 2, 2)));
+	REQUIRE(A.mult(B, true, false).size(1) == 0);
+	REQUIRE(A.gram().equal(A.trans().mult(A)));
+
+	// sums that don't fit wrap around the same way on every path: 65536^2 + 1 is 2^32 + 1
+	Matrix W(std::vector<int>{65536, 1, 1, 65536}, 2, 2);
+	Matrix WW(std::vector<int>{1, 131072, 131072, 1}, 2, 2);
+	REQUIRE(W.mult(W).equal(WW));
+	REQUIRE(W.mult(W, true, false).equal(WW));
+	REQUIRE(W.mult(W, false, true).equal(WW));
+	REQUIRE(W.mult(W, true, true).equal(WW));
+
+	// big enough for several blocks and threads
+	for (unsigned int size : { 5u, 300u }) {
+		unsigned int m = size + 7, n = size;
+		Matrix P(randomValues(m * n, size, -100, 100), m, n), Q(randomValues(m * n, size + 1, -100, 100), m, n);
+		Matrix Qt = Q.trans(), Pt = P.trans();
+		REQUIRE(P.mult(Q, true, false).equal(Pt.mult(Q)));
+		REQUIRE(P.mult(Q, false, true).equal(P.mult(Qt)));
+		REQUIRE(P.mult(Qt, true, true).equal(Pt.mult(Q)));
+		REQUIRE(P.gram().equal(P.mult(P, true, false)));
+		REQUIRE(Pt.trans().equal(P));
+	}
+}
+
+TEST_CASE("known-plaintext attack", "[Hill]")
+{
+	Matrix A(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3);
+	Matrix B(std::vector<int>{2, 14, 14, 10, 13, 25, 18, 27, 2}, 3, 3);
+	Hill O(A, true);
+
+	// the first few blocks repeat, so they can't all be used
+	std::vector<std::string> P = { "AAAAAAAAA", "ATTACK AT DAWN? NO.  ", "HOLD THE LINE" + std::string(2, ' ') };
+	std::vector<std::string> C;
+	for (std::size_t i = 0; i < P.size(); i++) {
+		C.push_back(O.encrypt(P[i]));
+	}
+
+	Hill LS;
+	REQUIRE(LS.kpa(P, C, 3));
+	REQUIRE(LS.getE().equal(A));
+	REQUIRE(LS.getD().equal(B));
+
+	// a pair that doesn't fit the key, or the wrong block size
+	C[2][0] = C[2][0] == 'A' ? 'B' : 'A';
+	Hill X;
+	REQUIRE_FALSE(X.kpa(P, C, 3));
+	REQUIRE_FALSE(X.kpa({ "AAAA" }, { "BBBB" }, 2));
+	REQUIRE(X.getE().equal(Matrix(std::vector<int>{2, 4, 3, 5}, 2, 2)));
+}
+
+TEST_CASE("ciphertext-only attack on a 2x2 key", "[Hill]")
+{
+	Hill LS;
+	std::string P = "WE HOLD THESE RULES TO BE SIMPLE. EVERY MESSAGE THAT LEAVES THIS OFFICE IS WRITTEN IN PLAIN WORDS "
+		"AND THEN LOCKED WITH THE KEY WE AGREED ON LAST WEEK. IF YOU CAN READ THIS THEN THE KEY WAS FOUND. "
+		"WHO ELSE COULD HAVE DONE IT? ONLY SOMEONE WITH A LOT OF TIME AND A FAST MACHINE.";
+	if (P.length() % 2 != 0) {
+		P += " ";
+	}
+	std::string C = LS.encrypt(P);
+
+	std::vector<Matrix> top = LS.coaCandidates(C, 2, 5, 2);
+	REQUIRE(top.size() == 5);
+	REQUIRE(top[0].equal(LS.getD()));
+
+	Hill X(Matrix(std::vector<int>{1, 0, 0, 1}, 2, 2), true);
+	REQUIRE(X.coa(C, 2));
+	REQUIRE(X.getE().equal(LS.getE()));
+	REQUIRE(X.decrypt(C) == P);
+}
+
+TEST_CASE("ciphertext-only attack on a 3x3 key", "[Hill]")
+{
+	Matrix A(std::vector<int>{3, 10, 28, 4, 7, 15, 6, 4, 10}, 3, 3);
+	Hill O(A, true);
+	std::string P = "WE HOLD THESE RULES TO BE SIMPLE. EVERY MESSAGE THAT LEAVES THIS OFFICE IS WRITTEN IN PLAIN WORDS "
+		"AND THEN LOCKED WITH THE KEY WE AGREED ON LAST WEEK. IF YOU CAN READ THIS THEN THE KEY WAS FOUND. "
+		"WHO ELSE COULD HAVE DONE IT? ONLY SOMEONE WITH A LOT OF TIME AND A FAST MACHINE. AND A LITTLE LUCK.";
+	P += std::string((3 - P.length() % 3) % 3, ' ');
+
+	Hill X;
+	REQUIRE(X.coa(O.encrypt(P), 3));
+	REQUIRE(X.getE().equal(A));
+	REQUIRE_FALSE(X.coa(O.encrypt(P), 7));
+
+	// with a model, rows are scored by the model's own single letters: trained on the text with every symbol v written as 2v mod 29,
+	// it makes the attack find the key that decrypts to that text, 2 * D
+	const std::string symbols = "ABCDEFGHIJKLMNOPQRSTUVWXYZ.? ";
+	std::string corpus, doubled;
+	for (int i = 0; i < 20; i++) {
+		corpus += P;
+	}
+	for (char ch : corpus) {
+		doubled += symbols[symbols.find(ch) * 2 % 29];
+	}
+	NGramModel M, T;
+	REQUIRE(M.build(corpus, 2));
+	REQUIRE(T.build(doubled, 2));
+	REQUIRE(M.unigrams().size() == 29);
+	REQUIRE(M.unigrams()[4] > M.unigrams()[16]);
+	REQUIRE(T.unigrams()[8] == M.unigrams()[4]);
+	Hill Y;
+	REQUIRE(Y.coa(O.encrypt(P), 3, M));
+	REQUIRE(Y.getE().equal(A));
+	REQUIRE(Y.coa(O.encrypt(P), 3, T));
+	REQUIRE(Y.getD().equal(O.getD().mult(2).map([](int x) { return x % 29; })));
+}
+
+TEST_CASE("n-gram model", "[NGramModel]")
+{
+	std::string corpus;
+	for (int i = 0; i < 20; i++) {
+		corpus += "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG. IS THAT NOT WHAT THEY SAY? THEN THE DOG WAKES UP AND CHASES THE FOX. ";
+	}
+
+	NGramModel M;
+	REQUIRE(M.order() == 0);
+	REQUIRE_FALSE(M.build(corpus, 5));
+	REQUIRE(M.build(corpus, 4));
+	REQUIRE(M.score("THE DOG AND THE FOX") > M.score("XQZ JVK WPY QZX JVQ"));
+
+	// a long text scores the same as two pieces that overlap by n - 1 characters, wherever it is cut
+	std::vector<unsigned char> text(1000);
+	for (std::size_t i = 0; i < text.size(); i++) {
+		text[i] = static_cast<unsigned char>(i * 7 % 29);
+	}
+	for (unsigned int n = 1; n <= 4; n++) {
+		NGramModel G;
+		REQUIRE(G.build(corpus, n));
+		for (std::size_t cut : { 1, 255, 256, 257, 700 }) {
+			REQUIRE(G.score(text.data(), text.size()) == G.score(text.data(), cut + n - 1) + G.score(text.data() + cut, text.size() - cut));
+		}
+	}
+
+	// saved and mapped back in, it scores exactly the same; the file is a fresh one in the temp directory, removed even if a check fails
+	struct TempFile {
+		std::string path;
+		TempFile() {
+#if defined(_WIN32)
+			path = std::tmpnam(nullptr);
+#else
+			const char* dir = std::getenv("TMPDIR");
+			std::string pattern = std::string(dir != nullptr ? dir : "/tmp") + "/ngram_test_XXXXXX";
+			std::vector<char> name(pattern.begin(), pattern.end());
+			name.push_back('\0');
+			int fd = mkstemp(name.data());
+			if (fd >= 0) {
+				close(fd);
+			}
+			path = name.data();
+#endif
+		}
+		~TempFile() {
+			std::remove(path.c_str());
+		}
+	} file;
+	REQUIRE(M.save(file.path));
+	NGramModel L;
+	REQUIRE(L.load(file.path));
+	REQUIRE(L.order() == 4);
+	REQUIRE(L.score("THE LAZY FOX") == M.score("THE LAZY FOX"));
+	std::remove(file.path.c_str());
+	REQUIRE_FALSE(L.load(file.path));
+	REQUIRE(L.order() == 0);
+
+	// and can drive the ciphertext-only attack
+	Hill LS;
+	std::string P = "THE LAZY DOG CHASES THE QUICK FOX OVER THE BROWN HILL. WHAT DOES THE FOX SAY? NOT MUCH. THE FOX JUMPS.";
+	Hill X;
+	REQUIRE(X.coa(LS.encrypt(P), 2, M));
+	REQUIRE(X.getE().equal(LS.getE()));
+
+	// an empty model scores everything alike, so both overloads turn it down rather than guess
+	Hill Y;
+	REQUIRE_FALSE(Y.coa(LS.encrypt(P), 2, L));
+	REQUIRE(Y.getE().equal(LS.getE()));
+	REQUIRE(Y.coaCandidates(LS.encrypt(P), 2, 3, L).empty());
+}